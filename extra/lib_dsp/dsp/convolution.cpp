@@ -0,0 +1,184 @@
+/**
+ * @file convolution.cpp
+ * @brief Partitioned FFT convolution
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+// Uniformly partitioned overlap-save convolution: the impulse is cut into
+// partitions of B samples, each one transformed once. Each block of B input
+// samples is transformed once too, and kept in a frequency-domain delay
+// line; an output block is the inverse transform of the sum of the products
+// of the last input spectra by the partition spectra.
+
+#include "convolution.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+typedef complex<double> Complex;
+
+// Partitions grow with the impulse so that there are at most MaxPartitions
+// of them: the cost per sample is O(log(impulseCount)).
+const int MinPartitionSize = 256;
+const int MaxPartitions = 16;
+
+int PartitionSize(int impulseCount)
+{
+  int size = MinPartitionSize;
+
+  while(size * MaxPartitions < impulseCount)
+    size *= 2;
+
+  return size;
+}
+
+// Plain multiplication: std::complex operator* handles infinities, and
+// doesn't get vectorized.
+Complex Mul(Complex a, Complex b)
+{
+  return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+// Radix-2 FFT of a fixed size (power of 2)
+struct FFT
+{
+  FFT(int size_) : size(size_), twiddles(size_ / 2), reversed(size_)
+  {
+    for(int i = 0; i < size / 2; ++i)
+      twiddles[i] = polar(1.0, -2 * M_PI * i / size);
+
+    int bits = 0;
+
+    while((1 << bits) < size)
+      ++bits;
+
+    for(int i = 0; i < size; ++i)
+    {
+      int r = 0;
+
+      for(int b = 0; b < bits; ++b)
+      {
+        if(i & (1 << b))
+          r |= 1 << (bits - 1 - b);
+      }
+
+      reversed[i] = r;
+    }
+  }
+
+  // In place. The inverse transform isn't scaled.
+  void Run(Complex* data, bool inverse) const
+  {
+    for(int i = 0; i < size; ++i)
+    {
+      if(i < reversed[i])
+        swap(data[i], data[reversed[i]]);
+    }
+
+    for(int len = 2; len <= size; len *= 2)
+    {
+      const int half = len / 2;
+      const int stride = size / len;
+
+      for(int i = 0; i < size; i += len)
+      {
+        for(int j = 0; j < half; ++j)
+        {
+          auto w = twiddles[j * stride];
+
+          if(inverse)
+            w = conj(w);
+
+          const auto a = data[i + j];
+          const auto b = Mul(data[i + j + half], w);
+          data[i + j] = a + b;
+          data[i + j + half] = a - b;
+        }
+      }
+    }
+  }
+
+  const int size;
+  vector<Complex> twiddles;
+  vector<int> reversed;
+};
+}
+
+void Convolve(float* samples, int count, const float* impulse, int impulseCount)
+{
+  if(impulseCount <= 0)
+  {
+    fill(samples, samples + count, 0.0f);
+    return;
+  }
+
+  const int B = PartitionSize(impulseCount);
+  const int N = 2 * B;
+  const int numPartitions = (impulseCount + B - 1) / B;
+
+  const FFT fft(N);
+
+  // spectra of the zero-padded partitions
+  vector<Complex> partitions(numPartitions * N);
+
+  for(int p = 0; p < numPartitions; ++p)
+  {
+    auto spectrum = &partitions[p * N];
+
+    for(int i = 0; i < B && p * B + i < impulseCount; ++i)
+      spectrum[i] = impulse[p * B + i];
+
+    fft.Run(spectrum, false);
+  }
+
+  const vector<float> input(samples, samples + count);
+
+  // frequency-domain delay line: spectrum of input block k at k % numPartitions
+  vector<Complex> delayLine(numPartitions * N);
+  vector<Complex> sum(N);
+
+  for(int k = 0; k * B < count; ++k)
+  {
+    // overlap-save: previous input block, then the current one
+    auto spectrum = &delayLine[(k % numPartitions) * N];
+
+    for(int i = 0; i < N; ++i)
+    {
+      const int n = (k - 1) * B + i;
+      spectrum[i] = n >= 0 && n < count ? input[n] : 0.0f;
+    }
+
+    fft.Run(spectrum, false);
+
+    fill(sum.begin(), sum.end(), Complex());
+
+    for(int p = 0; p < numPartitions && p <= k; ++p)
+    {
+      auto x = &delayLine[((k - p) % numPartitions) * N];
+      auto h = &partitions[p * N];
+
+      for(int i = 0; i < N; ++i)
+        sum[i] += Mul(x[i], h[i]);
+    }
+
+    fft.Run(sum.data(), true);
+
+    // the first half is circular convolution garbage
+    for(int i = 0; i < B && k * B + i < count; ++i)
+      samples[k * B + i] = sum[B + i].real() / N;
+  }
+}
@@ -0,0 +1,21 @@
+/**
+ * @file convolution.h
+ * @brief Partitioned FFT convolution
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+// Replaces the 'count' samples with their convolution by 'impulse'
+// (e.g a reverb impulse response). The tail beyond 'count' is dropped.
+// The result only depends on the inputs: it's the same on every run.
+void Convolve(float* samples, int count, const float* impulse, int impulseCount);
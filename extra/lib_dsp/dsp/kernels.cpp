@@ -0,0 +1,208 @@
+/**
+ * @file kernels.cpp
+ * @brief Sound synthesis/processing kernels
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+// Oscillators restart from an exactly computed phase at the beginning of
+// each block, so rounding errors of the recurrences don't accumulate over
+// long sounds.
+const int BlockSize = 1024;
+
+// Phase of sample 'i', in cycles, in [0;1[
+double Phase(double freq, int i)
+{
+  const double phase = freq * i;
+  return phase - floor(phase);
+}
+}
+
+// Four interleaved rotations of the vector (cos, sin): lane k produces the
+// samples i = 4n + k, and advances by 4 samples at each step.
+void Sine(float* samples, int count, double freq)
+{
+  const double step = 2 * M_PI * Phase(freq, 4);
+  const float c = cos(step);
+  const float s = sin(step);
+
+  for(int block = 0; block < count; block += BlockSize)
+  {
+    const int n = min(BlockSize, count - block);
+    float* dst = samples + block;
+
+    float re[4], im[4];
+
+    for(int k = 0; k < 4; ++k)
+    {
+      const double phase = 2 * M_PI * Phase(freq, block + k);
+      re[k] = cos(phase);
+      im[k] = sin(phase);
+    }
+
+    int i = 0;
+
+#ifdef __SSE2__
+    __m128 vre = _mm_loadu_ps(re);
+    __m128 vim = _mm_loadu_ps(im);
+    const __m128 vc = _mm_set1_ps(c);
+    const __m128 vs = _mm_set1_ps(s);
+
+    for(; i + 4 <= n; i += 4)
+    {
+      _mm_storeu_ps(dst + i, vim);
+      const __m128 r = _mm_sub_ps(_mm_mul_ps(vre, vc), _mm_mul_ps(vim, vs));
+      vim = _mm_add_ps(_mm_mul_ps(vre, vs), _mm_mul_ps(vim, vc));
+      vre = r;
+    }
+
+    _mm_storeu_ps(re, vre);
+    _mm_storeu_ps(im, vim);
+#endif
+
+    for(; i + 4 <= n; i += 4)
+    {
+      for(int k = 0; k < 4; ++k)
+      {
+        dst[i + k] = im[k];
+        const float r = re[k] * c - im[k] * s;
+        im[k] = re[k] * s + im[k] * c;
+        re[k] = r;
+      }
+    }
+
+    for(int k = 0; i < n; ++i, ++k)
+      dst[i] = im[k];
+  }
+}
+
+// 32-bit fixed point phase accumulator: the sample is 1 when the phase is
+// past half a cycle.
+void Square(float* samples, int count, double freq)
+{
+  const uint32_t inc = uint32_t(Phase(freq, 1) * 4294967296.0);
+
+  for(int block = 0; block < count; block += BlockSize)
+  {
+    const int n = min(BlockSize, count - block);
+    float* dst = samples + block;
+    uint32_t phase = uint32_t(Phase(freq, block) * 4294967296.0);
+    int i = 0;
+
+#ifdef __SSE2__
+    // no unsigned compare in SSE2: flip the sign bits, then compare signed
+    const __m128i half = _mm_set1_epi32(int(0x80000000u));
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i vinc = _mm_set1_epi32(int(inc * 4));
+    __m128i vphase = _mm_setr_epi32(int(phase), int(phase + inc), int(phase + inc * 2), int(phase + inc * 3));
+
+    for(; i + 4 <= n; i += 4)
+    {
+      const __m128i past = _mm_cmpgt_epi32(_mm_xor_si128(vphase, half), _mm_xor_si128(half, half));
+      _mm_storeu_ps(dst + i, _mm_and_ps(_mm_castsi128_ps(past), one));
+      vphase = _mm_add_epi32(vphase, vinc);
+    }
+
+    phase += inc * i;
+#endif
+
+    for(; i < n; ++i, phase += inc)
+      dst[i] = phase > 0x80000000u;
+  }
+}
+
+void Envelope(float* samples, int count)
+{
+  const double invN = 1.0 / count;
+  int i = 0;
+
+#ifdef __SSE2__
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 vinvN = _mm_set1_ps(invN);
+  const __m128i four = _mm_set1_epi32(4);
+  __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+  for(; i + 4 <= count; i += 4)
+  {
+    const __m128 f = _mm_sub_ps(one, _mm_mul_ps(_mm_cvtepi32_ps(index), vinvN));
+    _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), f));
+    index = _mm_add_epi32(index, four);
+  }
+
+#endif
+
+  for(; i < count; ++i)
+    samples[i] *= 1 - float(i) * float(invN);
+}
+
+void Amplify(float* samples, int count, float gain)
+{
+  int i = 0;
+
+#ifdef __SSE2__
+  const __m128 vgain = _mm_set1_ps(gain);
+
+  for(; i + 4 <= count; i += 4)
+    _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), vgain));
+
+#endif
+
+  for(; i < count; ++i)
+    samples[i] *= gain;
+}
+
+// Processed in blocks of 4 samples, in increasing order: when length >= 4,
+// a block only reads samples of the previous blocks, which are final.
+void Delay(float* samples, int count, int length, float feedback, float threshold)
+{
+  int i = length;
+
+#ifdef __SSE2__
+
+  if(length >= 4)
+  {
+    const __m128 vfeedback = _mm_set1_ps(feedback);
+    const __m128 vthreshold = _mm_set1_ps(threshold);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    for(; i + 4 <= count; i += 4)
+    {
+      const __m128 r = _mm_mul_ps(_mm_loadu_ps(samples + i - length), vfeedback);
+      const __m128 audible = _mm_cmpnlt_ps(_mm_andnot_ps(signBit, r), vthreshold);
+      _mm_storeu_ps(samples + i, _mm_add_ps(_mm_loadu_ps(samples + i), _mm_and_ps(r, audible)));
+    }
+  }
+
+#endif
+
+  for(; i < count; ++i)
+  {
+    float r = samples[i - length] * feedback;
+
+    if(fabs(r) < threshold)
+      r = 0;
+
+    samples[i] += r;
+  }
+}
@@ -0,0 +1,36 @@
+/**
+ * @file kernels.h
+ * @brief Sound synthesis/processing kernels
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+// All kernels work in place on 'count' float samples.
+// Frequencies are in cycles per sample (i.e frequency / sample rate).
+
+// samples[i] = sin(2 * pi * freq * i)
+void Sine(float* samples, int count, double freq);
+
+// samples[i] = 0 on the first half of each period, 1 on the second half
+void Square(float* samples, int count, double freq);
+
+// Linear fade-out: samples[i] *= 1 - i / count
+void Envelope(float* samples, int count);
+
+// samples[i] *= gain
+void Amplify(float* samples, int count, float gain);
+
+// Feedback echo: samples[i] += samples[i - length] * feedback, for each
+// i >= length, in increasing order (so echoes get echoed).
+// Echoes quieter than 'threshold' are dropped.
+void Delay(float* samples, int count, int length, float feedback, float threshold);
@@ -0,0 +1,5 @@
+srcs:=\
+	$(THIS)/dsp.d\
+	$(THIS)/dsp/convolution.cpp\
+	$(THIS)/dsp/kernels.cpp\
+
@@ -4,8 +4,7 @@ gdc demo/main.d\
   -o demo.exe \
   -Ilib_ktg\
   ktg.d\
-  ktg_generators.d\
-  ktg_filters.d\
   -std=c++11 \
-  ktg/*.cpp
+  ktg/*.cpp\
+  -lz
 ./demo.exe
@@ -0,0 +1,184 @@
+/**
+ * @file atlas.cpp
+ * @brief Baking of document variants into a texture atlas
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "atlas.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "parallel.h"
+
+using namespace std;
+
+namespace
+{
+struct Placement
+{
+  int x, y; // padded rectangle, in the atlas
+};
+
+// Shelf packing: tiles are placed left to right, in rows as high as their
+// first tile. 'order' is sorted by decreasing height, so rows waste little.
+bool Place(const vector<Texture>& tiles, const vector<int>& order, int gutter, int width, int height,
+           vector<Placement>& places)
+{
+  int x = 0;
+  int y = 0;
+  int rowHeight = 0;
+
+  for(auto i : order)
+  {
+    const int w = tiles[i].XRes + 2 * gutter;
+    const int h = tiles[i].YRes + 2 * gutter;
+
+    if(x + w > width)
+    {
+      x = 0;
+      y += rowHeight;
+      rowHeight = 0;
+    }
+
+    if(x + w > width || y + h > height)
+      return false;
+
+    places[i] = Placement { x, y };
+    x += w;
+    rowHeight = max(rowHeight, h);
+  }
+
+  return true;
+}
+
+int NextPowerOf2(int64_t x)
+{
+  int result = 1;
+
+  while(result < x)
+    result *= 2;
+
+  return result;
+}
+
+void CopyTile(Texture& atlas, const Texture& tile, Placement place, int gutter)
+{
+  const int w = tile.XRes + 2 * gutter;
+  const int h = tile.YRes + 2 * gutter;
+
+  for(int y = 0; y < h; ++y)
+  {
+    const int ty = ((y - gutter) % tile.YRes + tile.YRes) % tile.YRes;
+    auto src = tile.Data + ty * tile.XRes;
+    auto dst = atlas.Data + (place.y + y) * atlas.XRes + place.x;
+
+    for(int x = 0; x < w; ++x)
+      dst[x] = src[((x - gutter) % tile.XRes + tile.XRes) % tile.XRes];
+  }
+}
+}
+
+void PackAtlas(const vector<Texture>& tiles, int gutter, Texture& atlas, vector<AtlasTile>& uvs)
+{
+  gutter = max(gutter, 0);
+
+  vector<int> order(tiles.size());
+  int64_t area = 0;
+  int maxW = 1;
+  int maxH = 1;
+
+  for(int i = 0; i < int(tiles.size()); ++i)
+  {
+    const int w = tiles[i].XRes + 2 * gutter;
+    const int h = tiles[i].YRes + 2 * gutter;
+
+    order[i] = i;
+    area += int64_t(w) * h;
+    maxW = max(maxW, w);
+    maxH = max(maxH, h);
+  }
+
+  stable_sort(order.begin(), order.end(), [&] (int a, int b) { return tiles[a].YRes > tiles[b].YRes; });
+
+  // start from the smallest sizes which could hold everything, then grow
+  // the smaller dimension
+  int width = NextPowerOf2(maxW);
+  int height = NextPowerOf2(maxH);
+
+  while(int64_t(width) * height < area)
+  {
+    if(width <= height)
+      width *= 2;
+    else
+      height *= 2;
+  }
+
+  vector<Placement> places(tiles.size());
+
+  while(!Place(tiles, order, gutter, width, height, places))
+  {
+    if(width <= height)
+      width *= 2;
+    else
+      height *= 2;
+  }
+
+  atlas.Init(width, height);
+  memset(atlas.Data, 0, atlas.NPixels * sizeof(Pixel));
+
+  uvs.resize(tiles.size());
+
+  for(int i = 0; i < int(tiles.size()); ++i)
+  {
+    const auto place = places[i];
+    CopyTile(atlas, tiles[i], place, gutter);
+
+    auto& uv = uvs[i];
+    uv.u0 = float(place.x + gutter) / width;
+    uv.v0 = float(place.y + gutter) / height;
+    uv.u1 = float(place.x + gutter + tiles[i].XRes) / width;
+    uv.v1 = float(place.y + gutter + tiles[i].YRes) / height;
+  }
+}
+
+void BakeAtlas(const Document& doc, const vector<Variant>& variants, int gutter, Texture& atlas,
+               vector<AtlasTile>& uvs, int numThreads)
+{
+  const int count = int(variants.size());
+
+  vector<Texture> tiles(count);
+  vector<string> errors(count);
+
+  auto render = [&] (int i)
+                {
+                  try
+                  {
+                    RenderDocument(doc, variants[i], tiles[i]);
+                  }
+                  catch(exception& e)
+                  {
+                    errors[i] = e.what();
+                  }
+                };
+
+  // variants are independent
+  RunTaskGraph(vector<vector<int>>(count), numThreads, render);
+
+  for(int i = 0; i < count; ++i)
+  {
+    if(!errors[i].empty())
+      throw runtime_error("variant " + to_string(i) + ": " + errors[i]);
+  }
+
+  PackAtlas(tiles, gutter, atlas, uvs);
+}
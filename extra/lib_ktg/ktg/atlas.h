@@ -0,0 +1,40 @@
+/**
+ * @file atlas.h
+ * @brief Baking of document variants into a texture atlas
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include <vector>
+#include "runtime.h"
+
+// Texture coordinates of a tile in an atlas, gutter excluded, from 0 to 1.
+// (u0, v0) is the corner of the first texel of the tile (u along the
+// columns, v along the rows of the texture data), (u1, v1) the opposite one.
+struct AtlasTile
+{
+  float u0, v0, u1, v1;
+};
+
+// Packs 'tiles' into 'atlas', sized to the smallest powers of 2 found to
+// fit them. Each tile is surrounded by 'gutter' texels wrapped from its
+// opposite edges: textures tile, so filtering a tile near its edges never
+// reads its neighbours.
+// uvs[i] receives the coordinates of tiles[i].
+void PackAtlas(const std::vector<Texture>& tiles, int gutter, Texture& atlas, std::vector<AtlasTile>& uvs);
+
+// Renders the variants of 'doc' concurrently on up to 'numThreads' threads,
+// then packs them with PackAtlas.
+// Throws std::runtime_error if a variant fails.
+void BakeAtlas(const Document& doc, const std::vector<Variant>& variants, int gutter, Texture& atlas,
+               std::vector<AtlasTile>& uvs, int numThreads);
@@ -0,0 +1,487 @@
+/**
+ * @file blockcompress.cpp
+ * @brief Block compression (BCn) of textures, for GPUs
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+// The endpoints of each block are fitted on the 16-bit pixels, then the
+// nearest palette entry is picked for each pixel, 4 pixels at a time.
+// Errors are measured on the 0..255 scale of the decoded values.
+
+#include "blockcompress.h"
+#include "helpers.h"
+#include <cfloat>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// 16-bit channel to the 0..255 scale
+const float ToUnit = 255.0f / 65535.0f;
+
+void PutLE16(uint8_t* p, uint32_t value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+void PutLE32(uint8_t* p, uint32_t value)
+{
+  PutLE16(p, value);
+  PutLE16(p + 2, value >> 16);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Palette search                                                     ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+// Pixels of a block, one array per channel
+struct ColorBlock
+{
+  float r[16], g[16], b[16];
+};
+
+// Nearest of the 4 colors (pr, pg, pb) for each pixel of 'block'.
+// Writes the squared distances to 'errors', returns 2 bits per pixel.
+uint32_t PickColors(const ColorBlock& block, const float* pr, const float* pg, const float* pb, float* errors)
+{
+  int indices[16];
+  int i = 0;
+
+#ifdef __SSE2__
+
+  for(; i + 4 <= 16; i += 4)
+  {
+    const __m128 r = _mm_loadu_ps(block.r + i);
+    const __m128 g = _mm_loadu_ps(block.g + i);
+    const __m128 b = _mm_loadu_ps(block.b + i);
+    __m128 best = _mm_set1_ps(FLT_MAX);
+    __m128i index = _mm_setzero_si128();
+
+    for(int k = 0; k < 4; ++k)
+    {
+      const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(pr[k]));
+      const __m128 dg = _mm_sub_ps(g, _mm_set1_ps(pg[k]));
+      const __m128 db = _mm_sub_ps(b, _mm_set1_ps(pb[k]));
+      const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+      const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+      best = _mm_min_ps(d, best);
+      index = _mm_or_si128(_mm_andnot_si128(closer, index), _mm_and_si128(closer, _mm_set1_epi32(k)));
+    }
+
+    _mm_storeu_ps(errors + i, best);
+    _mm_storeu_si128((__m128i*)(indices + i), index);
+  }
+
+#endif
+
+  for(; i < 16; ++i)
+  {
+    float best = FLT_MAX;
+
+    for(int k = 0; k < 4; ++k)
+    {
+      const float dr = block.r[i] - pr[k];
+      const float dg = block.g[i] - pg[k];
+      const float db = block.b[i] - pb[k];
+      const float d = dr * dr + dg * dg + db * db;
+
+      if(d < best)
+      {
+        best = d;
+        indices[i] = k;
+      }
+    }
+
+    errors[i] = best;
+  }
+
+  uint32_t bits = 0;
+
+  for(i = 0; i < 16; ++i)
+    bits |= uint32_t(indices[i]) << (2 * i);
+
+  return bits;
+}
+
+// Nearest of the 8 values of 'palette' for each of the 16 'values'.
+// Returns 3 bits per value.
+uint64_t PickValues(const float* values, const float* palette)
+{
+  int indices[16];
+  int i = 0;
+
+#ifdef __SSE2__
+
+  for(; i + 4 <= 16; i += 4)
+  {
+    const __m128 v = _mm_loadu_ps(values + i);
+    __m128 best = _mm_set1_ps(FLT_MAX);
+    __m128i index = _mm_setzero_si128();
+
+    for(int k = 0; k < 8; ++k)
+    {
+      const __m128 dv = _mm_sub_ps(v, _mm_set1_ps(palette[k]));
+      const __m128 d = _mm_mul_ps(dv, dv);
+      const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+      best = _mm_min_ps(d, best);
+      index = _mm_or_si128(_mm_andnot_si128(closer, index), _mm_and_si128(closer, _mm_set1_epi32(k)));
+    }
+
+    _mm_storeu_si128((__m128i*)(indices + i), index);
+  }
+
+#endif
+
+  for(; i < 16; ++i)
+  {
+    float best = FLT_MAX;
+
+    for(int k = 0; k < 8; ++k)
+    {
+      const float dv = values[i] - palette[k];
+      const float d = dv * dv;
+
+      if(d < best)
+      {
+        best = d;
+        indices[i] = k;
+      }
+    }
+  }
+
+  uint64_t bits = 0;
+
+  for(i = 0; i < 16; ++i)
+    bits |= uint64_t(indices[i]) << (3 * i);
+
+  return bits;
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   BC1                                                                ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+// Bits replicated to 8 bits, as decoders do
+int Expand(int v, int bits)
+{
+  return (v << (8 - bits)) | (v >> (2 * bits - 8));
+}
+
+// Nearest 'bits' bits value, once expanded
+int Quantize(float v, int bits)
+{
+  const int top = (1 << bits) - 1;
+  const int q = clamp<int>(v * (top / 255.0f) + 0.5f, 0, top);
+  int best = q;
+
+  for(int n = max(q - 1, 0); n <= min(q + 1, top); ++n)
+  {
+    if(fabs(Expand(n, bits) - v) < fabs(Expand(best, bits) - v))
+      best = n;
+  }
+
+  return best;
+}
+
+uint16_t Pack565(float r, float g, float b)
+{
+  return (Quantize(r, 5) << 11) | (Quantize(g, 6) << 5) | Quantize(b, 5);
+}
+
+void Unpack565(uint16_t c, float& r, float& g, float& b)
+{
+  r = Expand(c >> 11, 5);
+  g = Expand((c >> 5) & 63, 6);
+  b = Expand(c & 31, 5);
+}
+
+struct ColorFit
+{
+  uint16_t c0, c1;
+  uint32_t indices;
+  float error;
+};
+
+// Indices of the pixels for the endpoints c0 and c1.
+// The 4 colors mode needs c0 > c1: when they're equal, all the pixels get c0.
+ColorFit FitIndices(const ColorBlock& block, uint16_t c0, uint16_t c1)
+{
+  if(c0 < c1)
+    swap(c0, c1);
+
+  float pr[4], pg[4], pb[4];
+  Unpack565(c0, pr[0], pg[0], pb[0]);
+  Unpack565(c1, pr[1], pg[1], pb[1]);
+
+  if(c0 == c1)
+  {
+    pr[1] = pr[2] = pr[3] = pr[0];
+    pg[1] = pg[2] = pg[3] = pg[0];
+    pb[1] = pb[2] = pb[3] = pb[0];
+  }
+  else
+  {
+    pr[2] = (2 * pr[0] + pr[1]) / 3;
+    pg[2] = (2 * pg[0] + pg[1]) / 3;
+    pb[2] = (2 * pb[0] + pb[1]) / 3;
+    pr[3] = (pr[0] + 2 * pr[1]) / 3;
+    pg[3] = (pg[0] + 2 * pg[1]) / 3;
+    pb[3] = (pb[0] + 2 * pb[1]) / 3;
+  }
+
+  float errors[16];
+
+  ColorFit fit;
+  fit.c0 = c0;
+  fit.c1 = c1;
+  fit.indices = PickColors(block, pr, pg, pb, errors);
+  fit.error = 0;
+
+  for(auto e : errors)
+    fit.error += e;
+
+  return fit;
+}
+
+// Least squares endpoints for the indices of 'fit'.
+// Returns false if the indices don't determine them (e.g all equal).
+bool RefineEndpoints(const ColorBlock& block, const ColorFit& fit, uint16_t& c0, uint16_t& c1)
+{
+  // weight of c0 for each index
+  static const float Weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+  const float* channels[3] = { block.r, block.g, block.b };
+  float aa = 0, ab = 0, bb = 0;
+  float ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+
+  for(int i = 0; i < 16; ++i)
+  {
+    const float a = Weights[(fit.indices >> (2 * i)) & 3];
+    const float b = 1.0f - a;
+
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+
+    for(int c = 0; c < 3; ++c)
+    {
+      ax[c] += a * channels[c][i];
+      bx[c] += b * channels[c][i];
+    }
+  }
+
+  const float det = aa * bb - ab * ab;
+
+  if(fabs(det) < 1e-3f)
+    return false;
+
+  float e0[3], e1[3];
+
+  for(int c = 0; c < 3; ++c)
+  {
+    e0[c] = (ax[c] * bb - bx[c] * ab) / det;
+    e1[c] = (bx[c] * aa - ax[c] * ab) / det;
+  }
+
+  c0 = Pack565(e0[0], e0[1], e0[2]);
+  c1 = Pack565(e1[0], e1[1], e1[2]);
+  return true;
+}
+}
+
+int BlockBytes(BlockFormat format)
+{
+  return format == BlockBC1 || format == BlockBC4 ? 8 : 16;
+}
+
+void EncodeBC1Block(uint8_t* dst, const Pixel* pixels)
+{
+  ColorBlock block;
+  float mean[3] = { 0, 0, 0 };
+
+  for(int i = 0; i < 16; ++i)
+  {
+    block.r[i] = pixels[i].r * ToUnit;
+    block.g[i] = pixels[i].g * ToUnit;
+    block.b[i] = pixels[i].b * ToUnit;
+    mean[0] += block.r[i];
+    mean[1] += block.g[i];
+    mean[2] += block.b[i];
+  }
+
+  for(auto& m : mean)
+    m /= 16;
+
+  // covariance: xx, xy, xz, yy, yz, zz
+  float cov[6] = { 0, 0, 0, 0, 0, 0 };
+
+  for(int i = 0; i < 16; ++i)
+  {
+    const float r = block.r[i] - mean[0];
+    const float g = block.g[i] - mean[1];
+    const float b = block.b[i] - mean[2];
+    cov[0] += r * r;
+    cov[1] += r * g;
+    cov[2] += r * b;
+    cov[3] += g * g;
+    cov[4] += g * b;
+    cov[5] += b * b;
+  }
+
+  // principal axis, by power iteration
+  float axis[3] = { 1, 1, 1 };
+
+  for(int iter = 0; iter < 4; ++iter)
+  {
+    const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+    const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+    const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+    const float norm = max(fabs(x), max(fabs(y), fabs(z)));
+
+    if(norm < 1e-6f)
+      break; // flat block: any axis will do
+
+    axis[0] = x / norm;
+    axis[1] = y / norm;
+    axis[2] = z / norm;
+  }
+
+  // endpoints: the pixels furthest apart along the axis
+  int lo = 0, hi = 0;
+  float minDot = FLT_MAX, maxDot = -FLT_MAX;
+
+  for(int i = 0; i < 16; ++i)
+  {
+    const float dot = block.r[i] * axis[0] + block.g[i] * axis[1] + block.b[i] * axis[2];
+
+    if(dot < minDot)
+    {
+      minDot = dot;
+      lo = i;
+    }
+
+    if(dot > maxDot)
+    {
+      maxDot = dot;
+      hi = i;
+    }
+  }
+
+  auto fit = FitIndices(block, Pack565(block.r[hi], block.g[hi], block.b[hi]),
+                        Pack565(block.r[lo], block.g[lo], block.b[lo]));
+
+  uint16_t c0, c1;
+
+  if(fit.error > 0 && RefineEndpoints(block, fit, c0, c1))
+  {
+    auto refined = FitIndices(block, c0, c1);
+
+    if(refined.error < fit.error)
+      fit = refined;
+  }
+
+  PutLE16(dst + 0, fit.c0);
+  PutLE16(dst + 2, fit.c1);
+  PutLE32(dst + 4, fit.indices);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   BC4                                                                ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+void EncodeBC4Block(uint8_t* dst, const Pixel* pixels, int channel)
+{
+  assert(channel >= 0 && channel < 4);
+
+  float values[16];
+  float lo = FLT_MAX, hi = -FLT_MAX;
+
+  for(int i = 0; i < 16; ++i)
+  {
+    values[i] = (&pixels[i].r)[channel] * ToUnit;
+    lo = min(lo, values[i]);
+    hi = max(hi, values[i]);
+  }
+
+  // 8 values mode: a0 > a1
+  const int a0 = int(hi + 0.5f);
+  const int a1 = int(lo + 0.5f);
+
+  float palette[8];
+
+  for(auto& p : palette)
+    p = a0;
+
+  if(a0 > a1)
+  {
+    palette[1] = a1;
+
+    for(int i = 2; i < 8; ++i)
+      palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+  }
+
+  const auto indices = PickValues(values, palette);
+
+  dst[0] = a0;
+  dst[1] = a1;
+
+  for(int i = 0; i < 6; ++i)
+    dst[2 + i] = indices >> (8 * i);
+}
+
+void EncodeBlockRow(uint8_t* dst, const Texture& tex, int blockRow, BlockFormat format)
+{
+  const int numBlocks = (tex.XRes + 3) / 4;
+  const int bytes = BlockBytes(format);
+
+  for(int bx = 0; bx < numBlocks; ++bx)
+  {
+    Pixel pixels[16];
+
+    for(int y = 0; y < 4; ++y)
+    {
+      auto row = tex.Data + min(blockRow * 4 + y, tex.YRes - 1) * tex.XRes;
+
+      for(int x = 0; x < 4; ++x)
+        pixels[y * 4 + x] = row[min(bx * 4 + x, tex.XRes - 1)];
+    }
+
+    switch(format)
+    {
+    case BlockBC1:
+      EncodeBC1Block(dst, pixels);
+      break;
+    case BlockBC3:
+      EncodeBC4Block(dst, pixels, 3);
+      EncodeBC1Block(dst + 8, pixels);
+      break;
+    case BlockBC4:
+      EncodeBC4Block(dst, pixels, 0);
+      break;
+    case BlockBC5:
+      EncodeBC4Block(dst, pixels, 0);
+      EncodeBC4Block(dst + 8, pixels, 1);
+      break;
+    }
+
+    dst += bytes;
+  }
+}
@@ -0,0 +1,42 @@
+/**
+ * @file blockcompress.h
+ * @brief Block compression (BCn) of textures, for GPUs
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include "gentexture.h"
+
+// Each 4x4 block of pixels is encoded on its own, in a fixed size.
+enum BlockFormat
+{
+  BlockBC1 = 0,         // rgb, 8 bytes per block (alpha is dropped)
+  BlockBC3,             // rgba, 16 bytes per block
+  BlockBC4,             // r, 8 bytes per block (masks, heightmaps)
+  BlockBC5,             // rg, 16 bytes per block (normal maps)
+};
+
+int BlockBytes(BlockFormat format);
+
+// Single block encoders, reading the 16 pixels of a block (row by row).
+// BC1 color: two 5:6:5 colors, and 2 bits per pixel to pick one of the
+// 4 colors between them.
+// BC4 channel: two 8-bit values, and 3 bits per pixel to pick one of the
+// 8 values between them. 'channel' is 0 (r), 1 (g), 2 (b) or 3 (a).
+void EncodeBC1Block(uint8_t* dst, const Pixel* pixels);
+void EncodeBC4Block(uint8_t* dst, const Pixel* pixels, int channel);
+
+// Encodes the row of blocks covering rows [4 * blockRow; 4 * blockRow + 4[
+// of 'tex', to 'dst'. Past the edges of the texture (e.g for 2x2 textures),
+// the blocks repeat its last row and column.
+void EncodeBlockRow(uint8_t* dst, const Texture& tex, int blockRow, BlockFormat format);
@@ -13,7 +13,7 @@
  * License, or (at your option) any later version.
  */
 
-#include "gentexture.h"
+#include "ktg.h"
 #include "helpers.h"
 
 void Ternary(Texture* dest, const Texture& in1Tex, const Texture& in2Tex, const Texture& in3Tex, TernaryOp op)
@@ -43,7 +43,7 @@ void Ternary(Texture* dest, const Texture& in1Tex, const Texture& in2Tex, const
 }
 
 void Paste(Texture* dest, const Texture& bgTex, const Texture& inTex, sF32 orgx, sF32 orgy, sF32 ux, sF32 uy, sF32 vx,
-           sF32 vy, CombineOp op, int mode)
+           sF32 vy, CombineOp op, int mode, Rect* changed)
 {
   assert(dest->SameSize(bgTex));
 
@@ -64,7 +64,20 @@ void Paste(Texture* dest, const Texture& bgTex, const Texture& inTex, sF32 orgx,
   sF32 detM = ux * vy - uy * vx;
 
   if(fabs(detM) * XRes * YRes < 0.25f) // smaller than a pixel? skip it.
+  {
+    if(changed)
+      *changed = EmptyRect();
+
     return;
+  }
+
+  if(changed)
+  {
+    *changed = Rect { minX, minY, maxX + 1, maxY + 1 };
+
+    if(IsEmptyRect(*changed))
+      *changed = EmptyRect();
+  }
 
   sF32 invM = (1 << 24) / detM;
   sF32 rmx = (minX + 0.5f) / XRes - orgx;
@@ -190,9 +203,9 @@ void Paste(Texture* dest, const Texture& bgTex, const Texture& inTex, sF32 orgx,
   }
 }
 
-void Bump(Texture* dest, const Texture& surface, const Texture& normals, const Texture* specular,
-          const Texture* falloffMap, sF32 px, sF32 py, sF32 pz, sF32 dx, sF32 dy, sF32 dz, Pixel ambient, Pixel diffuse,
-          bool directional)
+void Bump(Texture* dest, const Texture& surface, const Texture& normals, const CompiledGradient* specular,
+          const CompiledGradient* falloffMap, sF32 px, sF32 py, sF32 pz, sF32 dx, sF32 dy, sF32 dz, Pixel ambient, Pixel diffuse,
+          bool directional, const Rect* region)
 {
   assert(dest->SameSize(surface) && dest->SameSize(normals));
 
@@ -217,13 +230,15 @@ void Bump(Texture* dest, const Texture& surface, const Texture& normals, const T
 
   auto invX = 1.0f / dest->XRes;
   auto invY = 1.0f / dest->YRes;
-  Pixel* out = dest->Data;
-  const Pixel* surf = surface.Data;
-  const Pixel* normal = normals.Data;
+  auto const r = region ? IntersectRect(*region, FullRect(*dest)) : FullRect(*dest);
 
-  for(int y = 0; y < dest->YRes; y++)
+  for(int y = r.y0; y < r.y1; y++)
   {
-    for(int x = 0; x < dest->XRes; x++)
+    Pixel* out = &dest->Data[y * dest->XRes + r.x0];
+    const Pixel* surf = &surface.Data[y * dest->XRes + r.x0];
+    const Pixel* normal = &normals.Data[y * dest->XRes + r.x0];
+
+    for(int x = r.x0; x < r.x1; x++)
     {
       // determine vectors to light
       if(!directional)
@@ -259,7 +274,7 @@ void Bump(Texture* dest, const Texture& surface, const Texture& normals, const T
       if(falloffMap)
       {
         sF32 spotTerm = max(dx * L[0] + dy * L[1] + dz * L[2], 0.0f);
-        falloffMap->SampleGradient(falloff, spotTerm * (1 << 24));
+        falloffMap->Sample(falloff, spotTerm * (1 << 24));
       }
 
       // lighting calculation
@@ -284,7 +299,7 @@ void Bump(Texture* dest, const Texture& surface, const Texture& normals, const T
       {
         Pixel addTerm;
         sF32 NdotH = max(N[0] * H[0] + N[1] * H[1] + N[2] * H[2], 0.0f);
-        specular->SampleGradient(addTerm, NdotH * (1 << 24));
+        specular->Sample(addTerm, NdotH * (1 << 24));
 
         if(falloffMap)
           addTerm.CompositeMulC(falloff);
@@ -301,6 +316,22 @@ void Bump(Texture* dest, const Texture& surface, const Texture& normals, const T
   }
 }
 
+void Bump(Texture* dest, const Texture& surface, const Texture& normals, const Texture* specular,
+          const Texture* falloffMap, sF32 px, sF32 py, sF32 pz, sF32 dx, sF32 dy, sF32 dz, Pixel ambient, Pixel diffuse,
+          bool directional, const Rect* region)
+{
+  CompiledGradient compiledSpecular, compiledFalloff;
+
+  if(specular)
+    compiledSpecular.Init(*specular);
+
+  if(falloffMap)
+    compiledFalloff.Init(*falloffMap);
+
+  Bump(dest, surface, normals, specular ? &compiledSpecular : nullptr, falloffMap ? &compiledFalloff : nullptr,
+       px, py, pz, dx, dy, dz, ambient, diffuse, directional, region);
+}
+
 void LinearCombine(Texture* dest, Pixel color, sF32 constWeight, const LinearInput* inputs, int nInputs)
 {
   int w[256], uo[256], vo[256];
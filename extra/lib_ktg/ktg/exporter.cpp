@@ -0,0 +1,427 @@
+/**
+ * @file exporter.cpp
+ * @brief Image file export of textures
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "exporter.h"
+#include "blockcompress.h"
+#include "parallel.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <zlib.h>
+#include "helpers.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Row conversions                                                    ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+// 4x4 ordered dithering thresholds, scaled to the 16 bits dropped by
+// (v * 255) >> 16. Without dithering, the threshold is 0 everywhere,
+// which gives the same result as bmp_writer.d.
+static const int BayerMatrix[4][4] =
+{
+  { 0, 8, 2, 10 },
+  { 12, 4, 14, 6 },
+  { 3, 11, 1, 9 },
+  { 15, 7, 13, 5 },
+};
+
+static int DitherThreshold(int x, int y)
+{
+  return BayerMatrix[y & 3][x & 3] * 4096 + 2048;
+}
+
+// 16-bit RGBA to 8-bit RGBA
+static void ConvertRow8(uint8_t* dst, const Pixel* src, int count, int y, bool dither)
+{
+  auto in = &src->r;
+  int x = 0;
+
+  if(dither)
+  {
+#ifdef __SSE2__
+    const __m128i k255 = _mm_set1_epi16(255);
+
+    // 2 pixels per iteration: 32-bit products, plus one threshold per pixel
+    for(; x + 2 <= count; x += 2)
+    {
+      const __m128i v = _mm_loadu_si128((const __m128i*)(in + x * 4));
+      const __m128i lo = _mm_mullo_epi16(v, k255);
+      const __m128i hi = _mm_mulhi_epu16(v, k255);
+      __m128i p0 = _mm_add_epi32(_mm_unpacklo_epi16(lo, hi), _mm_set1_epi32(DitherThreshold(x, y)));
+      __m128i p1 = _mm_add_epi32(_mm_unpackhi_epi16(lo, hi), _mm_set1_epi32(DitherThreshold(x + 1, y)));
+      p0 = _mm_srli_epi32(p0, 16);
+      p1 = _mm_srli_epi32(p1, 16);
+      const __m128i r = _mm_packs_epi32(p0, p1);
+      _mm_storel_epi64((__m128i*)(dst + x * 4), _mm_packus_epi16(r, r));
+    }
+#endif
+
+    for(; x < count; ++x)
+    {
+      const int t = DitherThreshold(x, y);
+
+      for(int c = 0; c < 4; ++c)
+        dst[x * 4 + c] = (in[x * 4 + c] * 255 + t) >> 16;
+    }
+  }
+  else
+  {
+#ifdef __SSE2__
+    const __m128i k255 = _mm_set1_epi16(255);
+
+    // 4 pixels per iteration: (v * 255) >> 16 is the high half of the product
+    for(; x + 4 <= count; x += 4)
+    {
+      const __m128i v0 = _mm_loadu_si128((const __m128i*)(in + x * 4));
+      const __m128i v1 = _mm_loadu_si128((const __m128i*)(in + x * 4 + 8));
+      const __m128i r = _mm_packus_epi16(_mm_mulhi_epu16(v0, k255), _mm_mulhi_epu16(v1, k255));
+      _mm_storeu_si128((__m128i*)(dst + x * 4), r);
+    }
+#endif
+
+    for(; x < count; ++x)
+    {
+      for(int c = 0; c < 4; ++c)
+        dst[x * 4 + c] = (in[x * 4 + c] * 255) >> 16;
+    }
+  }
+}
+
+// 16-bit RGBA to big-endian 16-bit RGBA
+static void ConvertRow16BE(uint8_t* dst, const Pixel* src, int count)
+{
+  auto in = &src->r;
+  const int n = count * 4;
+  int i = 0;
+
+#ifdef __SSE2__
+
+  for(; i + 8 <= n; i += 8)
+  {
+    const __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+    _mm_storeu_si128((__m128i*)(dst + i * 2), _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+
+#endif
+
+  for(; i < n; ++i)
+  {
+    dst[i * 2 + 0] = in[i] >> 8;
+    dst[i * 2 + 1] = in[i] & 0xff;
+  }
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Streaming                                                          ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+namespace
+{
+// Rows converted at once, then written
+const int BandRows = 128;
+
+// Converts the rows of 'tex' band by band, and passes each band to 'write'.
+// convertRow(dst, row, y): converts row 'row' of the file, which is row 'y'
+// of the texture.
+template<typename ConvertFunc, typename WriteFunc>
+bool StreamRows(const Texture& tex, size_t pitch, bool bottomUp, ConvertFunc convertRow, WriteFunc write)
+{
+  vector<uint8_t> band(pitch * min(BandRows, tex.YRes));
+
+  for(int row0 = 0; row0 < tex.YRes; row0 += BandRows)
+  {
+    const int rows = min(BandRows, tex.YRes - row0);
+
+    auto convert = [&] (int i)
+                   {
+                     const int row = row0 + i;
+                     const int y = bottomUp ? tex.YRes - 1 - row : row;
+                     convertRow(&band[i * pitch], tex.Data + y * tex.XRes, y);
+                   };
+
+    ParallelFor(0, rows, 16, convert);
+
+    if(!write(band.data(), rows * pitch))
+      return false;
+  }
+
+  return true;
+}
+
+void PutLE2(uint8_t* p, uint32_t value)
+{
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+void PutLE4(uint8_t* p, uint32_t value)
+{
+  PutLE2(p, value);
+  PutLE2(p + 2, value >> 16);
+}
+
+void PutBE4(uint8_t* p, uint32_t value)
+{
+  p[0] = value >> 24;
+  p[1] = value >> 16;
+  p[2] = value >> 8;
+  p[3] = value;
+}
+
+bool WriteBMP(FILE* fp, const Texture& tex, bool dither)
+{
+  const size_t pitch = (tex.XRes * 3 + 3) & ~3;
+
+  uint8_t header[54] {};
+  header[0] = 'B';
+  header[1] = 'M';
+  PutLE4(header + 2, 54 + pitch * tex.YRes); // file size
+  PutLE4(header + 10, 54); // pixel offset
+  PutLE4(header + 14, 40); // info header size
+  PutLE4(header + 18, tex.XRes);
+  PutLE4(header + 22, tex.YRes);
+  PutLE2(header + 26, 1); // planes
+  PutLE2(header + 28, 24); // bits per pixel
+  PutLE4(header + 34, tex.XRes * tex.YRes * 3);
+  PutLE4(header + 38, 2835);
+  PutLE4(header + 42, 2835);
+
+  if(fwrite(header, sizeof header, 1, fp) != 1)
+    return false;
+
+  auto convertRow = [&] (uint8_t* dst, const Pixel* src, int y)
+                    {
+                      vector<uint8_t> rgba(tex.XRes * 4);
+                      ConvertRow8(rgba.data(), src, tex.XRes, y, dither);
+
+                      for(int x = 0; x < tex.XRes; ++x)
+                      {
+                        dst[x * 3 + 0] = rgba[x * 4 + 2];
+                        dst[x * 3 + 1] = rgba[x * 4 + 1];
+                        dst[x * 3 + 2] = rgba[x * 4 + 0];
+                      }
+
+                      memset(dst + tex.XRes * 3, 0, pitch - tex.XRes * 3);
+                    };
+
+  auto write = [&] (const uint8_t* data, size_t size)
+               {
+                 return fwrite(data, 1, size, fp) == size;
+               };
+
+  return StreamRows(tex, pitch, true, convertRow, write);
+}
+
+bool WriteRaw(FILE* fp, const Texture& tex, bool wide, bool dither)
+{
+  if(wide)
+    return fwrite(tex.Data, sizeof(Pixel), tex.NPixels, fp) == size_t(tex.NPixels);
+
+  auto convertRow = [&] (uint8_t* dst, const Pixel* src, int y)
+                    {
+                      ConvertRow8(dst, src, tex.XRes, y, dither);
+                    };
+
+  auto write = [&] (const uint8_t* data, size_t size)
+               {
+                 return fwrite(data, 1, size, fp) == size;
+               };
+
+  return StreamRows(tex, tex.XRes * 4, false, convertRow, write);
+}
+
+bool WritePNGChunk(FILE* fp, const char* type, const uint8_t* data, size_t size)
+{
+  uint8_t header[8];
+  PutBE4(header, size);
+  memcpy(header + 4, type, 4);
+
+  uint8_t footer[4];
+  auto crc = crc32(0, header + 4, 4);
+
+  if(size > 0) // crc32() resets on null data
+    crc = crc32(crc, data, size);
+
+  PutBE4(footer, crc);
+
+  return fwrite(header, sizeof header, 1, fp) == 1
+         && fwrite(data, 1, size, fp) == size
+         && fwrite(footer, sizeof footer, 1, fp) == 1;
+}
+
+bool WritePNG(FILE* fp, const Texture& tex, bool wide, bool dither)
+{
+  static const uint8_t signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+  if(fwrite(signature, sizeof signature, 1, fp) != 1)
+    return false;
+
+  uint8_t ihdr[13];
+  PutBE4(ihdr + 0, tex.XRes);
+  PutBE4(ihdr + 4, tex.YRes);
+  ihdr[8] = wide ? 16 : 8; // bit depth
+  ihdr[9] = 6; // color type: RGBA
+  ihdr[10] = 0; // compression: deflate
+  ihdr[11] = 0; // filter method
+  ihdr[12] = 0; // no interlacing
+
+  if(!WritePNGChunk(fp, "IHDR", ihdr, sizeof ihdr))
+    return false;
+
+  // each row starts with its filter type: 0 (none)
+  auto convertRow = [&] (uint8_t* dst, const Pixel* src, int y)
+                    {
+                      dst[0] = 0;
+
+                      if(wide)
+                        ConvertRow16BE(dst + 1, src, tex.XRes);
+                      else
+                        ConvertRow8(dst + 1, src, tex.XRes, y, dither);
+                    };
+
+  z_stream zs {};
+
+  if(deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+    return false;
+
+  vector<uint8_t> idat(1 << 16);
+
+  // deflates 'size' bytes, writing an IDAT chunk each time the buffer is full
+  auto compress = [&] (const uint8_t* data, size_t size, int flush)
+                  {
+                    zs.next_in = (Bytef*)data;
+                    zs.avail_in = size;
+
+                    while(true)
+                    {
+                      zs.next_out = idat.data();
+                      zs.avail_out = idat.size();
+
+                      const int ret = deflate(&zs, flush);
+
+                      if(ret == Z_STREAM_ERROR)
+                        return false;
+
+                      const size_t produced = idat.size() - zs.avail_out;
+
+                      if(produced > 0 && !WritePNGChunk(fp, "IDAT", idat.data(), produced))
+                        return false;
+
+                      if(flush == Z_FINISH ? ret == Z_STREAM_END : zs.avail_out != 0)
+                        return true;
+                    }
+                  };
+
+  auto write = [&] (const uint8_t* data, size_t size)
+               {
+                 return compress(data, size, Z_NO_FLUSH);
+               };
+
+  const size_t pitch = 1 + tex.XRes * (wide ? 8 : 4);
+  const bool ok = StreamRows(tex, pitch, false, convertRow, write) && compress(nullptr, 0, Z_FINISH);
+
+  deflateEnd(&zs);
+
+  return ok && WritePNGChunk(fp, "IEND", nullptr, 0);
+}
+
+// DirectDraw Surface, without mipmaps
+bool WriteDDS(FILE* fp, const Texture& tex, BlockFormat format)
+{
+  static const char* const FourCC[] = { "DXT1", "DXT5", "ATI1", "ATI2" };
+
+  const int blocksX = (tex.XRes + 3) / 4;
+  const int blocksY = (tex.YRes + 3) / 4;
+  const size_t pitch = size_t(blocksX) * BlockBytes(format);
+
+  uint8_t header[128] {};
+  memcpy(header, "DDS ", 4);
+  PutLE4(header + 4, 124); // header size
+  PutLE4(header + 8, 0x81007); // caps, height, width, pixel format, linear size
+  PutLE4(header + 12, tex.YRes);
+  PutLE4(header + 16, tex.XRes);
+  PutLE4(header + 20, pitch * blocksY);
+  PutLE4(header + 76, 32); // pixel format size
+  PutLE4(header + 80, 0x4); // four cc
+  memcpy(header + 84, FourCC[format], 4);
+  PutLE4(header + 108, 0x1000); // texture
+
+  if(fwrite(header, sizeof header, 1, fp) != 1)
+    return false;
+
+  const int bandBlocks = BandRows / 4;
+  vector<uint8_t> band(pitch * min(bandBlocks, blocksY));
+
+  for(int row0 = 0; row0 < blocksY; row0 += bandBlocks)
+  {
+    const int rows = min(bandBlocks, blocksY - row0);
+
+    auto encode = [&] (int i)
+                  {
+                    EncodeBlockRow(&band[i * pitch], tex, row0 + i, format);
+                  };
+
+    ParallelFor(0, rows, 1, encode);
+
+    if(fwrite(band.data(), 1, rows * pitch, fp) != rows * pitch)
+      return false;
+  }
+
+  return true;
+}
+}
+
+bool ExportTexture(const Texture& tex, const char* path, ExportFormat format, int flags)
+{
+  FILE* fp = fopen(path, "wb");
+
+  if(!fp)
+    return false;
+
+  const bool wide = flags & Export16Bit;
+  const bool dither = flags & ExportDither;
+  bool ok = false;
+
+  switch(format)
+  {
+  case ExportBMP:
+    ok = WriteBMP(fp, tex, dither);
+    break;
+  case ExportPNG:
+    ok = WritePNG(fp, tex, wide, dither);
+    break;
+  case ExportRaw:
+    ok = WriteRaw(fp, tex, wide, dither);
+    break;
+  case ExportBC1:
+  case ExportBC3:
+  case ExportBC4:
+  case ExportBC5:
+    ok = WriteDDS(fp, tex, BlockFormat(format - ExportBC1));
+    break;
+  }
+
+  ok = !ferror(fp) && ok;
+
+  return fclose(fp) == 0 && ok;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file exporter.h
+ * @brief Image file export of textures
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include "gentexture.h"
+
+enum ExportFormat
+{
+  ExportBMP = 0,        // 24-bit BGR, bottom-up (always 8-bit)
+  ExportPNG,            // RGBA, 8 or 16 bits per channel
+  ExportRaw,            // RGBA, 8 or 16 bits per channel (native byte order), no header
+  ExportBC1,            // DDS, block compressed (see blockcompress.h): RGB
+  ExportBC3,            // DDS, block compressed: RGBA
+  ExportBC4,            // DDS, block compressed: R
+  ExportBC5,            // DDS, block compressed: RG
+};
+
+enum ExportFlags
+{
+  Export8Bit = 0,       // 8 bits per channel
+  Export16Bit = 1,      // keep the 16 bits of the texture (PNG and raw only)
+  ExportDither = 2,     // ordered dithering when reducing to 8 bits (not DDS)
+};
+
+// Writes 'tex' to 'path'. Returns false on I/O error.
+// Rows (or rows of blocks) are converted in parallel and written band by
+// band, so the whole converted image is never in memory.
+bool ExportTexture(const Texture& tex, const char* path, ExportFormat format, int flags);
@@ -13,8 +13,10 @@
  * License, or (at your option) any later version.
  */
 
-#include "gentexture.h"
+#include "ktg.h"
 #include "helpers.h"
+#include "parallel.h"
+#include <complex>
 #include <cstring>
 #include <vector>
 
@@ -97,47 +99,79 @@ void CoordMatrixTransform(Texture* dest, const Texture& in, Matrix44& matrix, in
   }
 }
 
-void ColorRemap(Texture* dest, const Texture& inTex, const Texture& mapR, const Texture& mapG, const Texture& mapB)
+void Rotozoom(Texture* dest, const Texture& in, sF32 angle, sF32 zoom, int mode)
 {
-  assert(dest->SameSize(inTex));
+  const sF32 cosTheta = cos(double(angle));
+  const sF32 sinTheta = sin(double(angle));
 
-  for(int i = 0; i < dest->NPixels; i++)
+  Matrix44 mat =
   {
-    const Pixel& in = inTex.Data[i];
-    Pixel& out = dest->Data[i];
+    { cosTheta * zoom, -sinTheta * zoom, 0.0f, 0.0f },
+    { sinTheta * zoom, cosTheta * zoom, 0.0f, 0.0f },
+    { 0.0f, 0.0f, 1.0f, 0.0f },
+    { 0.0f, 0.0f, 0.0f, 1.0f },
+  };
 
-    if(in.a == 65535) // alpha==1, everything easy.
-    {
-      Pixel colR, colG, colB;
+  CoordMatrixTransform(dest, in, mat, mode);
+}
 
-      mapR.SampleGradient(colR, (in.r << 8) + ((in.r + 128) >> 8));
-      mapG.SampleGradient(colG, (in.g << 8) + ((in.g + 128) >> 8));
-      mapB.SampleGradient(colB, (in.b << 8) + ((in.b + 128) >> 8));
+// Remaps one pixel through the three gradients
+static void RemapPixel(Pixel& out, const Pixel& in, const CompiledGradient& mapR, const CompiledGradient& mapG,
+                       const CompiledGradient& mapB)
+{
+  if(in.a == 65535) // alpha==1, everything easy.
+  {
+    Pixel colR, colG, colB;
 
-      out.r = min(colR.r + colG.r + colB.r, 65535);
-      out.g = min(colR.g + colG.g + colB.g, 65535);
-      out.b = min(colR.b + colG.b + colB.b, 65535);
-      out.a = in.a;
-    }
-    else if(in.a) // alpha!=0
-    {
-      Pixel colR, colG, colB;
-      uint32_t invA = (65535U << 16) / in.a;
+    mapR.Sample(colR, (in.r << 8) + ((in.r + 128) >> 8));
+    mapG.Sample(colG, (in.g << 8) + ((in.g + 128) >> 8));
+    mapB.Sample(colB, (in.b << 8) + ((in.b + 128) >> 8));
 
-      mapR.SampleGradient(colR, UMulShift8(min(in.r, in.a), invA));
-      mapG.SampleGradient(colG, UMulShift8(min(in.g, in.a), invA));
-      mapB.SampleGradient(colB, UMulShift8(min(in.b, in.a), invA));
+    out.r = min(colR.r + colG.r + colB.r, 65535);
+    out.g = min(colR.g + colG.g + colB.g, 65535);
+    out.b = min(colR.b + colG.b + colB.b, 65535);
+    out.a = in.a;
+  }
+  else if(in.a) // alpha!=0
+  {
+    Pixel colR, colG, colB;
+    uint32_t invA = (65535U << 16) / in.a;
 
-      out.r = MulIntens(min(colR.r + colG.r + colB.r, 65535), in.a);
-      out.g = MulIntens(min(colR.g + colG.g + colB.g, 65535), in.a);
-      out.b = MulIntens(min(colR.b + colG.b + colB.b, 65535), in.a);
-      out.a = in.a;
+    mapR.Sample(colR, UMulShift8(min(in.r, in.a), invA));
+    mapG.Sample(colG, UMulShift8(min(in.g, in.a), invA));
+    mapB.Sample(colB, UMulShift8(min(in.b, in.a), invA));
+
+    out.r = MulIntens(min(colR.r + colG.r + colB.r, 65535), in.a);
+    out.g = MulIntens(min(colR.g + colG.g + colB.g, 65535), in.a);
+    out.b = MulIntens(min(colR.b + colG.b + colB.b, 65535), in.a);
+    out.a = in.a;
+  }
+  else // alpha==0
+    out = in;
+}
+
+void ColorRemap(Texture* dest, const Texture& inTex, const CompiledGradient& mapR, const CompiledGradient& mapG,
+                const CompiledGradient& mapB, const Rect* region)
+{
+  assert(dest->SameSize(inTex));
+
+  auto const r = region ? IntersectRect(*region, FullRect(*dest)) : FullRect(*dest);
+
+  for(int y = r.y0; y < r.y1; y++)
+  {
+    for(int x = r.x0; x < r.x1; x++)
+    {
+      RemapPixel(dest->Data[y * dest->XRes + x], inTex.Data[y * dest->XRes + x], mapR, mapG, mapB);
     }
-    else // alpha==0
-      out = in;
   }
 }
 
+void ColorRemap(Texture* dest, const Texture& inTex, const Texture& mapR, const Texture& mapG, const Texture& mapB,
+                const Rect* region)
+{
+  ColorRemap(dest, inTex, CompiledGradient(mapR), CompiledGradient(mapG), CompiledGradient(mapB), region);
+}
+
 void CoordRemap(Texture* dest, const Texture& in, const Texture& remapTex, sF32 strengthU, sF32 strengthV, int mode)
 {
   assert(dest->SameSize(remapTex));
@@ -172,53 +206,66 @@ void CoordRemap(Texture* dest, const Texture& in, const Texture& remapTex, sF32
   }
 }
 
-void Derive(Texture* dest, const Texture& in, DeriveOp op, sF32 strength)
+void Derive(Texture* dest, const Texture& in, DeriveOp op, sF32 strength, const Rect* region)
 {
   assert(dest->SameSize(in));
 
-  Pixel* out = dest->Data;
-
   const auto XRes = dest->XRes;
   const auto YRes = dest->YRes;
+  auto const r = region ? IntersectRect(*region, FullRect(*dest)) : FullRect(*dest);
 
-  for(int y = 0; y < YRes; y++)
+  for(int y = r.y0; y < r.y1; y++)
   {
-    for(int x = 0; x < XRes; x++)
+    // neighbour rows are wrapped once per row
+    auto const row = &in.Data[y * XRes];
+    auto const above = &in.Data[((y + 1) & (YRes - 1)) * XRes];
+    auto const below = &in.Data[((y - 1) & (YRes - 1)) * XRes];
+    auto const out = &dest->Data[y * XRes];
+
+    auto derive = [&] (int x, int left, int right)
+                  {
+                    auto const dx2 = row[right].r - row[left].r;
+                    auto const dy2 = above[x].r - below[x].r;
+
+                    sF32 dx = dx2 * strength / (2 * 65535.0f);
+                    sF32 dy = dy2 * strength / (2 * 65535.0f);
+                    switch(op)
+                    {
+                    case DeriveGradient:
+                      out[x].r = clamp<int>(dx * 32768.0f + 32768.0f, 0, 65535);
+                      out[x].g = clamp<int>(dy * 32768.0f + 32768.0f, 0, 65535);
+                      out[x].b = 0;
+                      out[x].a = 65535;
+                      break;
+
+                    case DeriveNormals:
+                      {
+                        // (1 0 dx)^T x (0 1 dy)^T = (-dx -dy 1)
+                        sF32 scale = 32768.0f * sFInvSqrt(1.0f + dx * dx + dy * dy);
+
+                        out[x].r = clamp<int>(-dx * scale + 32768.0f, 0, 65535);
+                        out[x].g = clamp<int>(-dy * scale + 32768.0f, 0, 65535);
+                        out[x].b = clamp<int>(scale + 32768.0f, 0, 65535);
+                        out[x].a = 65535;
+                      }
+                      break;
+                    }
+                  };
+
+    // only the first and last columns have wrapped neighbours
+    int x = r.x0;
+
+    if(x == 0 && x < r.x1)
     {
-      auto const ax = y * XRes + ((x + 1) & (XRes - 1));
-      auto const bx = y * XRes + ((x - 1) & (XRes - 1));
-      auto const dx2 = in.Data[ax].r - in.Data[bx].r;
-
-      auto const ay = x + ((y + 1) & (YRes - 1)) * XRes;
-      auto const by = x + ((y - 1) & (YRes - 1)) * XRes;
-      auto const dy2 = in.Data[ay].r - in.Data[by].r;
+      derive(0, XRes - 1, 1 & (XRes - 1));
+      x++;
+    }
 
-      sF32 dx = dx2 * strength / (2 * 65535.0f);
-      sF32 dy = dy2 * strength / (2 * 65535.0f);
-      switch(op)
-      {
-      case DeriveGradient:
-        out->r = clamp<int>(dx * 32768.0f + 32768.0f, 0, 65535);
-        out->g = clamp<int>(dy * 32768.0f + 32768.0f, 0, 65535);
-        out->b = 0;
-        out->a = 65535;
-        break;
-
-      case DeriveNormals:
-        {
-          // (1 0 dx)^T x (0 1 dy)^T = (-dx -dy 1)
-          sF32 scale = 32768.0f * sFInvSqrt(1.0f + dx * dx + dy * dy);
-
-          out->r = clamp<int>(-dx * scale + 32768.0f, 0, 65535);
-          out->g = clamp<int>(-dy * scale + 32768.0f, 0, 65535);
-          out->b = clamp<int>(scale + 32768.0f, 0, 65535);
-          out->a = 65535;
-        }
-        break;
-      }
+    for(auto const inner = min(r.x1, XRes - 1); x < inner; x++)
+      derive(x, x - 1, x + 1);
 
-      out++;
-    }
+    for(; x < r.x1; x++)
+      derive(x, (x - 1) & (XRes - 1), (x + 1) & (XRes - 1));
   }
 }
 
@@ -231,8 +278,28 @@ static int WrapCoord(int x, int width, int mode)
     return clamp(x, 0, width - 1);
 }
 
-// Size is half of edge length in pixels, 26.6 fixed point
-static void Blur1DBuffer(Pixel* dst, const Pixel* src, int width, int sizeFixed, int wrapMode)
+// Pixels read by Blur1DBuffer on each side of a line
+static int BlurGuard(int sizeFixed)
+{
+  return ((sizeFixed + 32) >> 6) + 1;
+}
+
+// Fills the 'guard' pixels on each side of line[0;width[ with the pixels
+// WrapCoord would read instead. The line can then be read past its ends.
+// Refilling is cheap: it is done before each pass, and whenever the wrap
+// mode changes.
+static void FillGuardBand(Pixel* line, int width, int guard, int wrapMode)
+{
+  for(int i = 1; i <= guard; i++)
+  {
+    line[-i] = line[WrapCoord(-i, width, wrapMode)];
+    line[width - 1 + i] = line[WrapCoord(width - 1 + i, width, wrapMode)];
+  }
+}
+
+// Size is half of edge length in pixels, 26.6 fixed point.
+// 'src' must have a guard band of BlurGuard(sizeFixed) pixels (see FillGuardBand).
+static void Blur1DBuffer(Pixel* dst, const Pixel* src, int width, int sizeFixed)
 {
   assert(sizeFixed > 32); // kernel should be wider than one pixel
   int frac = (sizeFixed - 32) & 63;
@@ -242,55 +309,23 @@ static void Blur1DBuffer(Pixel* dst, const Pixel* src, int width, int sizeFixed,
   uint32_t denom = sizeFixed * 2;
   uint32_t bias = denom / 2;
 
-  // initialize accumulators
+  // initialize accumulators.
+  // When clamping, the guard band repeats the first pixel over and over.
   uint32_t accu[4];
 
-  if(wrapMode == 0) // wrap around
-  {
-    // leftmost and rightmost pixels (the partially covered ones)
-    int xl = WrapCoord(-offset, width, wrapMode);
-    int xr = WrapCoord(offset, width, wrapMode);
-    accu[0] = frac * (src[xl].r + src[xr].r) + bias;
-    accu[1] = frac * (src[xl].g + src[xr].g) + bias;
-    accu[2] = frac * (src[xl].b + src[xr].b) + bias;
-    accu[3] = frac * (src[xl].a + src[xr].a) + bias;
+  // leftmost and rightmost pixels (the partially covered ones)
+  accu[0] = frac * (src[-offset].r + src[offset].r) + bias;
+  accu[1] = frac * (src[-offset].g + src[offset].g) + bias;
+  accu[2] = frac * (src[-offset].b + src[offset].b) + bias;
+  accu[3] = frac * (src[-offset].a + src[offset].a) + bias;
 
-    // inner part of filter kernel
-    for(int x = -offset + 1; x <= offset - 1; x++)
-    {
-      int xc = WrapCoord(x, width, wrapMode);
-
-      accu[0] += src[xc].r << 6;
-      accu[1] += src[xc].g << 6;
-      accu[2] += src[xc].b << 6;
-      accu[3] += src[xc].a << 6;
-    }
-  }
-  else // clamp on edge
+  // inner part of filter kernel
+  for(int x = -offset + 1; x <= offset - 1; x++)
   {
-    // on the left edge, the first pixel is repeated over and over
-    accu[0] = src[0].r * (sizeFixed + 32) + bias;
-    accu[1] = src[0].g * (sizeFixed + 32) + bias;
-    accu[2] = src[0].b * (sizeFixed + 32) + bias;
-    accu[3] = src[0].a * (sizeFixed + 32) + bias;
-
-    // rightmost pixel
-    int xr = WrapCoord(offset, width, wrapMode);
-    accu[0] += frac * src[xr].r;
-    accu[1] += frac * src[xr].g;
-    accu[2] += frac * src[xr].b;
-    accu[3] += frac * src[xr].a;
-
-    // inner part of filter kernel (the right half)
-    for(int x = 1; x <= offset - 1; x++)
-    {
-      int xc = WrapCoord(x, width, wrapMode);
-
-      accu[0] += src[xc].r << 6;
-      accu[1] += src[xc].g << 6;
-      accu[2] += src[xc].b << 6;
-      accu[3] += src[xc].a << 6;
-    }
+    accu[0] += src[x].r << 6;
+    accu[1] += src[x].g << 6;
+    accu[2] += src[x].b << 6;
+    accu[3] += src[x].a << 6;
   }
 
   // generate output pixels
@@ -303,101 +338,899 @@ static void Blur1DBuffer(Pixel* dst, const Pixel* src, int width, int sizeFixed,
     dst[x].a = accu[3] / denom;
 
     // update accumulator
-    int xl0 = WrapCoord(x - offset + 0, width, wrapMode);
-    int xl1 = WrapCoord(x - offset + 1, width, wrapMode);
-    int xr0 = WrapCoord(x + offset + 0, width, wrapMode);
-    int xr1 = WrapCoord(x + offset + 1, width, wrapMode);
+    auto const& l0 = src[x - offset + 0];
+    auto const& l1 = src[x - offset + 1];
+    auto const& r0 = src[x + offset + 0];
+    auto const& r1 = src[x + offset + 1];
+
+    accu[0] += 64 * (r0.r - l1.r) + frac * (r1.r - r0.r - l0.r + l1.r);
+    accu[1] += 64 * (r0.g - l1.g) + frac * (r1.g - r0.g - l0.g + l1.g);
+    accu[2] += 64 * (r0.b - l1.b) + frac * (r1.b - r0.b - l0.b + l1.b);
+    accu[3] += 64 * (r0.a - l1.a) + frac * (r1.a - r0.a - l0.a + l1.a);
+  }
+}
+
+// Minimum (erode) or maximum (dilate) of the 2*radius+1 pixels around each
+// pixel, whatever the radius: van Herk / Gil-Werman. The line is cut into
+// blocks of 2*radius+1 pixels, whose running extrema from the start (g) and
+// from the end (h) give each window in one operation.
+// 'src' must have a guard band of 'radius' pixels (see FillGuardBand).
+// 'g' and 'h' hold width + 2 * radius pixels.
+template<typename Op>
+static void Morph1DBuffer(Pixel* dst, const Pixel* src, int width, int radius, Op op, Pixel* g, Pixel* h)
+{
+  auto const w = 2 * radius + 1;
+  auto const ext = src - radius;
+  auto const m = width + 2 * radius;
+
+  for(int b = 0; b < m; b += w)
+  {
+    auto const end = min(b + w, m) - 1;
+
+    g[b] = ext[b];
+
+    for(int i = b + 1; i <= end; i++)
+      g[i] = op(g[i - 1], ext[i]);
 
-    accu[0] += 64 * (src[xr0].r - src[xl1].r) + frac * (src[xr1].r - src[xr0].r - src[xl0].r + src[xl1].r);
-    accu[1] += 64 * (src[xr0].g - src[xl1].g) + frac * (src[xr1].g - src[xr0].g - src[xl0].g + src[xl1].g);
-    accu[2] += 64 * (src[xr0].b - src[xl1].b) + frac * (src[xr1].b - src[xr0].b - src[xl0].b + src[xl1].b);
-    accu[3] += 64 * (src[xr0].a - src[xl1].a) + frac * (src[xr1].a - src[xr0].a - src[xl0].a + src[xl1].a);
+    h[end] = ext[end];
+
+    for(int i = end - 1; i >= b; i--)
+      h[i] = op(h[i + 1], ext[i]);
+  }
+
+  // the window [x;x+2*radius] spans two blocks at most
+  for(int x = 0; x < width; x++)
+    dst[x] = op(h[x], g[x + 2 * radius]);
+}
+
+// Window of a line needed to blur [x0;x1[ exactly.
+// The window is blurred in clamp mode: its ends are discarded, except at the
+// edges of a clamped texture, where they match the full line.
+struct BlurWindow
+{
+  int lo, hi;
+  int mode;
+};
+
+static BlurWindow GetLineWindow(int x0, int x1, int width, int margin, int wrapMode)
+{
+  BlurWindow w { x0 - margin, x1 + margin, 1 };
+
+  if(w.hi - w.lo >= width)
+  {
+    // whole line, blur it as usual
+    w.lo = 0;
+    w.hi = width;
+    w.mode = wrapMode;
   }
+  else if(wrapMode)
+  {
+    w.lo = max(w.lo, 0);
+    w.hi = min(w.hi, width);
+  }
+
+  return w;
+}
+
+static BlurWindow GetBlurWindow(int x0, int x1, int width, int sizeFixed, int order, int wrapMode)
+{
+  int offset = (sizeFixed + 32) >> 6;
+  return GetLineWindow(x0, x1, width, order * (offset + 1), wrapMode);
 }
 
-void Blur(Texture* dest, const Texture& inImg, sF32 sizex, sF32 sizey, int order, int wrapMode)
+// Blurs 'order' times the window 'w' of a line, whose pixels are given
+// by 'line(x)' (x being unwrapped), and writes [x0;x1[ to 'dst'.
+// The buffers must have a guard band of BlurGuard(sizeFixed) pixels.
+template<typename Line>
+static void BlurSpan(Pixel* dst, int dstStride, Line line, BlurWindow w, int x0, int x1, int sizeFixed, int order,
+                     Pixel* buf1, Pixel* buf2)
+{
+  const int n = w.hi - w.lo;
+
+  for(int i = 0; i < n; i++)
+    buf1[i] = line(w.lo + i);
+
+  auto const guard = BlurGuard(sizeFixed);
+
+  // blur order times, ping-ponging between buffers
+  for(int i = 0; i < order; i++)
+  {
+    FillGuardBand(buf1, n, guard, w.mode);
+    Blur1DBuffer(buf2, buf1, n, sizeFixed);
+    swap(buf1, buf2);
+  }
+
+  for(int x = x0; x < x1; x++)
+    dst[(x - x0) * dstStride] = buf1[x - w.lo];
+}
+
+static int BlurSizeFixed(sF32 size, int res)
+{
+  return clamp(size, 0.0f, 1.0f) * 64 * res / 2;
+}
+
+Rect BlurFootprint(const Texture& tex, Rect r, sF32 sizex, sF32 sizey, int order, int wrapMode)
+{
+  if(order < 1)
+    return r;
+
+  int sizePixX = BlurSizeFixed(sizex, tex.XRes);
+  int sizePixY = BlurSizeFixed(sizey, tex.YRes);
+  int dx = sizePixX > 32 ? order * (((sizePixX + 32) >> 6) + 1) : 0;
+  int dy = sizePixY > 32 ? order * (((sizePixY + 32) >> 6) + 1) : 0;
+
+  return GrowRect(tex, r, dx, dy, wrapMode);
+}
+
+void Blur(Texture* dest, const Texture& inImg, sF32 sizex, sF32 sizey, int order, int wrapMode, const Rect* region)
 {
   assert(dest->SameSize(inImg));
 
-  int sizePixX = clamp(sizex, 0.0f, 1.0f) * 64 * inImg.XRes / 2;
-  int sizePixY = clamp(sizey, 0.0f, 1.0f) * 64 * inImg.YRes / 2;
+  int sizePixX = BlurSizeFixed(sizex, inImg.XRes);
+  int sizePixY = BlurSizeFixed(sizey, inImg.YRes);
+
+  auto const XRes = dest->XRes;
+  auto const YRes = dest->YRes;
+  auto const r = region ? IntersectRect(*region, FullRect(*dest)) : FullRect(*dest);
+
+  if(IsEmptyRect(r))
+    return;
 
   // no blur at all? just copy!
   if(order < 1 || (sizePixX <= 32 && sizePixY <= 32))
   {
-    *dest = inImg;
+    if(dest != &inImg)
+    {
+      for(int y = r.y0; y < r.y1; y++)
+        memcpy(&dest->Data[y * XRes + r.x0], &inImg.Data[y * XRes + r.x0], (r.x1 - r.x0) * sizeof(Pixel));
+    }
+
     return;
   }
 
-  auto const XRes = dest->XRes;
-  auto const YRes = dest->YRes;
+  auto const modeX = (wrapMode & ClampU) ? 1 : 0;
+  auto const modeY = (wrapMode & ClampV) ? 1 : 0;
 
-  // allocate pixel buffers
-  int bufSize = max(XRes, YRes);
+  // rows needed by the vertical pass
+  BlurWindow rows { r.y0, r.y1, modeY };
 
-  vector<Pixel> buf1_mem(bufSize);
-  vector<Pixel> buf2_mem(bufSize);
+  if(sizePixY > 32)
+    rows = GetBlurWindow(r.y0, r.y1, YRes, sizePixY, order, modeY);
 
-  Pixel* buf1 = buf1_mem.data();
-  Pixel* buf2 = buf2_mem.data();
-  const Texture* input = &inImg;
+  int width = r.x1 - r.x0;
+  vector<Pixel> tmp_mem;
 
-  // horizontal blur
+  // horizontal blur of the needed rows, restricted to the output columns
   if(sizePixX > 32)
   {
-    // go through image row by row
-    for(int y = 0; y < YRes; y++)
-    {
-      // copy pixels into buffer 1
-      memcpy(buf1, &input->Data[y * XRes], XRes * sizeof(Pixel));
+    auto const cols = GetBlurWindow(r.x0, r.x1, XRes, sizePixX, order, modeX);
 
-      // blur order times, ping-ponging between buffers
-      for(int i = 0; i < order; i++)
-      {
-        Blur1DBuffer(buf2, buf1, XRes, sizePixX, (wrapMode & ClampU) ? 1 : 0);
-        swap(buf1, buf2);
-      }
+    // if a vertical pass follows, keep the rows in a temporary buffer
+    Pixel* hdst = dest->Data;
+    int hstride = XRes;
+    int row0 = 0;
 
-      // copy pixels back
-      memcpy(&dest->Data[y * XRes], buf1, XRes * sizeof(Pixel));
+    if(sizePixY > 32)
+    {
+      tmp_mem.resize((rows.hi - rows.lo) * width);
+      hdst = tmp_mem.data() - r.x0;
+      hstride = width;
+      row0 = rows.lo;
     }
 
-    input = dest;
+    // rows only read themselves: they can be blurred in place, in parallel
+    auto const guard = BlurGuard(sizePixX);
+
+    auto blurRows = [&] (int first, int last)
+                    {
+                      vector<Pixel> mem1(XRes + 2 * guard), mem2(XRes + 2 * guard);
+
+                      for(int y = first; y < last && !IsCancelled(); y++)
+                      {
+                        auto const srcRow = &inImg.Data[(y & (YRes - 1)) * XRes];
+                        auto line = [=](int x) { return srcRow[x & (XRes - 1)]; };
+                        BlurSpan(&hdst[(y - row0) * hstride + r.x0], 1, line, cols, r.x0, r.x1, sizePixX, order,
+                                 mem1.data() + guard, mem2.data() + guard);
+                      }
+                    };
+
+    ParallelForChunks(rows.lo, rows.hi, Tuning().blurRows, blurRows);
   }
 
-  // vertical blur
+  // vertical blur of the output columns
   if(sizePixY > 32)
   {
-    // go through image column by column
-    for(int x = 0; x < XRes; x++)
+    // rows come either from the temporary buffer, or straight from the input
+    const Pixel* input = inImg.Data;
+    int stride = XRes;
+    int row0 = 0;
+    int rowMask = YRes - 1;
+
+    if(sizePixX > 32)
+    {
+      input = tmp_mem.data() - r.x0;
+      stride = width;
+      row0 = rows.lo;
+      rowMask = -1;
+    }
+
+    // Columns are blurred by blocks, so each row is read and written once
+    // per block rather than once per column.
+    auto const block = max(1, Tuning().blurColumns);
+    auto const n = rows.hi - rows.lo;
+    auto const guard = BlurGuard(sizePixY);
+    auto const columnStride = n + 2 * guard;
+
+    auto blurColumns = [&] (int first, int last)
+                       {
+                         vector<Pixel> mem1(block * columnStride), mem2(block * columnStride);
+
+                         for(int b = first; b < last && !IsCancelled(); b++)
+                         {
+                           auto const x0 = r.x0 + b * block;
+                           auto const count = min(block, r.x1 - x0);
+
+                           for(int i = 0; i < n; i++)
+                           {
+                             auto const src = &input[((rows.lo + i - row0) & rowMask) * stride + x0];
+
+                             for(int c = 0; c < count; c++)
+                               mem1[c * columnStride + guard + i] = src[c];
+                           }
+
+                           // blur order times, ping-ponging between buffers
+                           for(int c = 0; c < count; c++)
+                           {
+                             Pixel* buf1 = &mem1[c * columnStride + guard];
+                             Pixel* buf2 = &mem2[c * columnStride + guard];
+
+                             for(int i = 0; i < order; i++)
+                             {
+                               FillGuardBand(buf1, n, guard, rows.mode);
+                               Blur1DBuffer(buf2, buf1, n, sizePixY);
+                               swap(buf1, buf2);
+                             }
+                           }
+
+                           auto const& result = (order & 1) ? mem2 : mem1;
+
+                           for(int y = r.y0; y < r.y1; y++)
+                           {
+                             auto const dst = &dest->Data[y * XRes + x0];
+
+                             for(int c = 0; c < count; c++)
+                               dst[c] = result[c * columnStride + guard + y - rows.lo];
+                           }
+                         }
+                       };
+
+    ParallelForChunks(0, (width + block - 1) / block, 1, blurColumns);
+  }
+}
+
+// ---- Morphology
+
+namespace
+{
+struct PixelMin
+{
+  Pixel operator () (Pixel a, Pixel b) const
+  {
+    return Pixel { min(a.r, b.r), min(a.g, b.g), min(a.b, b.b), min(a.a, b.a) };
+  }
+};
+
+struct PixelMax
+{
+  Pixel operator () (Pixel a, Pixel b) const
+  {
+    return Pixel { max(a.r, b.r), max(a.g, b.g), max(a.b, b.b), max(a.a, b.a) };
+  }
+};
+
+int MorphRadius(sF32 size, int res)
+{
+  return clamp(size, 0.0f, 1.0f) * res / 2;
+}
+
+// Same structure as Blur: a horizontal pass of the needed rows, restricted
+// to the output columns, then a vertical pass by blocks of columns.
+template<typename Op>
+void Morph2D(Texture* dest, const Texture& in, int rx, int ry, Op op, int modeX, int modeY, Rect r)
+{
+  auto const XRes = in.XRes;
+  auto const YRes = in.YRes;
+  auto const rows = GetLineWindow(r.y0, r.y1, YRes, ry, modeY);
+  auto const cols = GetLineWindow(r.x0, r.x1, XRes, rx, modeX);
+  auto const width = r.x1 - r.x0;
+  auto const n = rows.hi - rows.lo;
+
+  // the horizontal pass only reads 'in': 'dest' may be the same texture
+  vector<Pixel> tmp(n * width);
+
+  auto horizontal = [&] (int first, int last)
+                    {
+                      auto const count = cols.hi - cols.lo;
+                      vector<Pixel> line(count + 2 * rx), out(count), g(count + 2 * rx), h(count + 2 * rx);
+
+                      for(int y = first; y < last && !IsCancelled(); y++)
+                      {
+                        auto const src = &in.Data[(y & (YRes - 1)) * XRes];
+
+                        for(int i = 0; i < count; i++)
+                          line[rx + i] = src[(cols.lo + i) & (XRes - 1)];
+
+                        FillGuardBand(&line[rx], count, rx, cols.mode);
+                        Morph1DBuffer(out.data(), &line[rx], count, rx, op, g.data(), h.data());
+                        memcpy(&tmp[(y - rows.lo) * width], &out[r.x0 - cols.lo], width * sizeof(Pixel));
+                      }
+                    };
+
+  ParallelForChunks(rows.lo, rows.hi, Tuning().blurRows, horizontal);
+
+  auto const block = max(1, Tuning().blurColumns);
+  auto const stride = n + 2 * ry;
+
+  auto vertical = [&] (int first, int last)
+                  {
+                    vector<Pixel> mem(block * stride), out(n), g(stride), h(stride);
+
+                    for(int b = first; b < last && !IsCancelled(); b++)
+                    {
+                      auto const x0 = r.x0 + b * block;
+                      auto const count = min(block, r.x1 - x0);
+
+                      for(int i = 0; i < n; i++)
+                      {
+                        auto const src = &tmp[i * width + x0 - r.x0];
+
+                        for(int c = 0; c < count; c++)
+                          mem[c * stride + ry + i] = src[c];
+                      }
+
+                      for(int c = 0; c < count; c++)
+                      {
+                        auto const column = &mem[c * stride + ry];
+                        FillGuardBand(column, n, ry, rows.mode);
+                        Morph1DBuffer(out.data(), column, n, ry, op, g.data(), h.data());
+
+                        for(int y = r.y0; y < r.y1; y++)
+                          dest->Data[y * XRes + x0 + c] = out[y - rows.lo];
+                      }
+                    }
+                  };
+
+  ParallelForChunks(0, (width + block - 1) / block, 1, vertical);
+}
+}
+
+void Morphology(Texture* dest, const Texture& in, sF32 sizex, sF32 sizey, MorphOp op, int wrapMode,
+                const Rect* region)
+{
+  assert(dest->SameSize(in));
+
+  auto const r = region ? IntersectRect(*region, FullRect(*dest)) : FullRect(*dest);
+
+  if(IsEmptyRect(r))
+    return;
+
+  auto const rx = MorphRadius(sizex, in.XRes);
+  auto const ry = MorphRadius(sizey, in.YRes);
+  auto const modeX = (wrapMode & ClampU) ? 1 : 0;
+  auto const modeY = (wrapMode & ClampV) ? 1 : 0;
+
+  switch(op)
+  {
+  case MorphDilate:
+    Morph2D(dest, in, rx, ry, PixelMax(), modeX, modeY, r);
+    break;
+
+  case MorphErode:
+    Morph2D(dest, in, rx, ry, PixelMin(), modeX, modeY, r);
+    break;
+
+  case MorphOpen:
+  case MorphClose:
     {
-      // copy pixels into buffer 1
-      const Pixel* src = &input->Data[x];
-      Pixel* dst = buf1;
+      // the second pass reads the first one around 'r'
+      Texture tmp(in.XRes, in.YRes);
+      auto const grown = GrowRect(in, r, rx, ry, wrapMode);
 
-      for(int y = 0; y < YRes; y++)
+      if(op == MorphOpen)
       {
-        *dst++ = *src;
-        src += XRes;
+        Morph2D(&tmp, in, rx, ry, PixelMin(), modeX, modeY, grown);
+        Morph2D(dest, tmp, rx, ry, PixelMax(), modeX, modeY, r);
       }
+      else
+      {
+        Morph2D(&tmp, in, rx, ry, PixelMax(), modeX, modeY, grown);
+        Morph2D(dest, tmp, rx, ry, PixelMin(), modeX, modeY, r);
+      }
+    }
+    break;
+  }
+}
 
-      // blur order times, ping-ponging between buffers
-      for(int i = 0; i < order; i++)
+Rect MorphologyFootprint(const Texture& tex, Rect r, sF32 sizex, sF32 sizey, MorphOp op, int wrapMode)
+{
+  auto const passes = (op == MorphOpen || op == MorphClose) ? 2 : 1;
+  return GrowRect(tex, r, passes * MorphRadius(sizex, tex.XRes), passes * MorphRadius(sizey, tex.YRes), wrapMode);
+}
+
+// ---- Convolution
+
+namespace
+{
+// Non-separable kernels with at least this many taps go through the FFT
+const int FftMinTaps = 81;
+
+struct Accu
+{
+  double r, g, b, a;
+
+  void Add(double w, const Pixel& p)
+  {
+    r += w * p.r;
+    g += w * p.g;
+    b += w * p.b;
+    a += w * p.a;
+  }
+
+  void Add(double w, const Accu& p)
+  {
+    r += w * p.r;
+    g += w * p.g;
+    b += w * p.b;
+    a += w * p.a;
+  }
+};
+
+uint16_t ToChannel(double v)
+{
+  return uint16_t(clamp(v, 0.0, 65535.0) + 0.5);
+}
+
+void Store(Pixel& out, const Accu& s)
+{
+  out.r = ToChannel(s.r);
+  out.g = ToChannel(s.g);
+  out.b = ToChannel(s.b);
+  out.a = ToChannel(s.a);
+}
+
+// Coordinates [first;first+n[ of an axis, wrapped or clamped
+vector<int> AxisTable(int first, int n, int size, int mode)
+{
+  vector<int> r(n);
+
+  for(int i = 0; i < n; i++)
+    r[i] = WrapCoord(first + i, size, mode);
+
+  return r;
+}
+
+// Splits the kernel into a column 'ky' and a row 'kx', if it is their product
+bool SplitKernel(const float* kernel, int kw, int kh, vector<double>& kx, vector<double>& ky)
+{
+  int pivot = 0;
+
+  for(int i = 1; i < kw * kh; i++)
+  {
+    if(fabs(kernel[i]) > fabs(kernel[pivot]))
+      pivot = i;
+  }
+
+  const double maxAbs = fabs(kernel[pivot]);
+
+  if(maxAbs == 0)
+  {
+    kx.assign(kw, 0.0);
+    ky.assign(kh, 1.0);
+    return true;
+  }
+
+  const int px = pivot % kw;
+  const int py = pivot / kw;
+
+  kx.assign(kernel + py * kw, kernel + py * kw + kw);
+  ky.resize(kh);
+
+  for(int y = 0; y < kh; y++)
+    ky[y] = kernel[y * kw + px] / double(kernel[pivot]);
+
+  for(int y = 0; y < kh; y++)
+  {
+    for(int x = 0; x < kw; x++)
+    {
+      if(fabs(kernel[y * kw + x] - ky[y] * kx[x]) > 1e-6 * maxAbs)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+void ConvolveDirect(Texture* dest, const Texture& in, const float* kernel, int kw, int kh, int modeX, int modeY,
+                    Rect r)
+{
+  auto const cols = AxisTable(r.x0 - kw / 2, r.x1 - r.x0 + kw - 1, in.XRes, modeX);
+  auto const rows = AxisTable(r.y0 - kh / 2, r.y1 - r.y0 + kh - 1, in.YRes, modeY);
+
+  auto convolveRows = [&] (int first, int last)
+                      {
+                        for(int y = first; y < last && !IsCancelled(); y++)
+                        {
+                          auto const out = &dest->Data[y * dest->XRes];
+
+                          for(int x = r.x0; x < r.x1; x++)
+                          {
+                            auto const col = &cols[x - r.x0];
+                            Accu s {};
+
+                            for(int j = 0; j < kh; j++)
+                            {
+                              auto const src = &in.Data[rows[y - r.y0 + j] * in.XRes];
+                              auto const w = &kernel[j * kw];
+
+                              for(int i = 0; i < kw; i++)
+                                s.Add(w[i], src[col[i]]);
+                            }
+
+                            Store(out[x], s);
+                          }
+                        }
+                      };
+
+  ParallelForChunks(r.y0, r.y1, Tuning().convolveRows, convolveRows);
+}
+
+// Horizontal pass by 'kx' of the rows needed by the vertical pass by 'ky'.
+// Each thread keeps the last 'kh' rows of the horizontal pass in a ring,
+// instead of the whole pass: the vertical pass of a row only needs these.
+void ConvolveSeparable(Texture* dest, const Texture& in, const vector<double>& kx, const vector<double>& ky,
+                       int modeX, int modeY, Rect r)
+{
+  const int kw = kx.size();
+  const int kh = ky.size();
+  const int width = r.x1 - r.x0;
+
+  auto const cols = AxisTable(r.x0 - kw / 2, width + kw - 1, in.XRes, modeX);
+  auto const rows = AxisTable(r.y0 - kh / 2, r.y1 - r.y0 + kh - 1, in.YRes, modeY);
+
+  auto convolveRows = [&] (int first, int last)
+                      {
+                        vector<Accu> ring(kh * width);
+                        vector<const Accu*> taps(kh);
+
+                        // row 'j' of the horizontal pass, i.e of source row rows[j]
+                        auto horizontal = [&] (int j)
+                                          {
+                                            auto const src = &in.Data[rows[j] * in.XRes];
+                                            auto const dst = &ring[(j % kh) * width];
+
+                                            for(int x = 0; x < width; x++)
+                                            {
+                                              Accu s {};
+
+                                              for(int i = 0; i < kw; i++)
+                                                s.Add(kx[i], src[cols[x + i]]);
+
+                                              dst[x] = s;
+                                            }
+                                          };
+
+                        for(int j = first - r.y0; j < first - r.y0 + kh - 1; j++)
+                          horizontal(j);
+
+                        for(int y = first; y < last && !IsCancelled(); y++)
+                        {
+                          horizontal(y - r.y0 + kh - 1);
+
+                          for(int j = 0; j < kh; j++)
+                            taps[j] = &ring[((y - r.y0 + j) % kh) * width];
+
+                          auto const out = &dest->Data[y * dest->XRes + r.x0];
+
+                          for(int x = 0; x < width; x++)
+                          {
+                            Accu s {};
+
+                            for(int j = 0; j < kh; j++)
+                              s.Add(ky[j], taps[j][x]);
+
+                            Store(out[x], s);
+                          }
+                        }
+                      };
+
+  ParallelForChunks(r.y0, r.y1, Tuning().convolveRows, convolveRows);
+}
+
+typedef complex<double> Complex;
+
+// In-place radix-2 FFT of 'n' values, n being a power of 2.
+// 'twiddles' holds exp(-2i.pi.k/n) for k in [0;n/2[. The inverse isn't scaled.
+void Fft(Complex* v, int n, const Complex* twiddles, bool inverse)
+{
+  for(int i = 1, j = 0; i < n; i++)
+  {
+    int bit = n >> 1;
+
+    for(; j & bit; bit >>= 1)
+      j ^= bit;
+
+    j ^= bit;
+
+    if(i < j)
+      swap(v[i], v[j]);
+  }
+
+  for(int len = 2; len <= n; len <<= 1)
+  {
+    auto const half = len / 2;
+    auto const step = n / len;
+
+    for(int i = 0; i < n; i += len)
+    {
+      for(int k = 0; k < half; k++)
       {
-        Blur1DBuffer(buf2, buf1, YRes, sizePixY, (wrapMode & ClampV) ? 1 : 0);
-        swap(buf1, buf2);
+        auto const w = inverse ? conj(twiddles[k * step]) : twiddles[k * step];
+        auto const a = v[i + k];
+        auto const b = v[i + k + half] * w;
+        v[i + k] = a + b;
+        v[i + k + half] = a - b;
       }
+    }
+  }
+}
+
+// FFT of a n x n block: rows, then columns
+void Fft2D(Complex* block, int n, const Complex* twiddles, bool inverse, Complex* column)
+{
+  for(int y = 0; y < n; y++)
+    Fft(&block[y * n], n, twiddles, inverse);
+
+  for(int x = 0; x < n; x++)
+  {
+    for(int y = 0; y < n; y++)
+      column[y] = block[y * n + x];
+
+    Fft(column, n, twiddles, inverse);
+
+    for(int y = 0; y < n; y++)
+      block[y * n + x] = column[y];
+  }
+}
+
+// Overlap-save: each tile of output is the valid part of the circular
+// convolution of a n x n block of input. The blocks are read with the
+// wrapped or clamped coordinates, as the other paths.
+// Two channels are transformed at once, as the real and imaginary parts.
+void ConvolveFft(Texture* dest, const Texture& in, const float* kernel, int kw, int kh, int modeX, int modeY, Rect r)
+{
+  int n = 32;
+
+  while(n < 2 * max(kw, kh))
+    n *= 2;
+
+  const int tileW = n - kw + 1;
+  const int tileH = n - kh + 1;
+
+  // The tiles are aligned on the texture, not on 'r': a pixel gets the same
+  // rounding errors whatever the region, so a region gives exactly the same
+  // pixels as the whole texture.
+  const int firstX = r.x0 / tileW * tileW;
+  const int firstY = r.y0 / tileH * tileH;
+  const int tilesX = (r.x1 - firstX + tileW - 1) / tileW;
+  const int tilesY = (r.y1 - firstY + tileH - 1) / tileH;
+
+  vector<Complex> twiddles(n / 2);
+
+  for(int k = 0; k < n / 2; k++)
+    twiddles[k] = polar(1.0, -2.0 * M_PI * k / n);
+
+  // spectrum of the flipped kernel, including the scale of the inverse FFT
+  vector<Complex> spectrum(n * n);
+
+  {
+    vector<Complex> column(n);
+
+    for(int j = 0; j < kh; j++)
+      for(int i = 0; i < kw; i++)
+        spectrum[((n - j) % n) * n + (n - i) % n] = kernel[j * kw + i] / double(n * n);
+
+    Fft2D(spectrum.data(), n, twiddles.data(), false, column.data());
+  }
+
+  auto convolveTiles = [&] (int first, int last)
+                       {
+                         vector<Complex> rg(n * n), ba(n * n), column(n);
+
+                         for(int t = first; t < last && !IsCancelled(); t++)
+                         {
+                           auto const x0 = firstX + (t % tilesX) * tileW;
+                           auto const y0 = firstY + (t / tilesX) * tileH;
+                           auto const cols = AxisTable(x0 - kw / 2, n, in.XRes, modeX);
+
+                           for(int y = 0; y < n; y++)
+                           {
+                             auto const src = &in.Data[WrapCoord(y0 - kh / 2 + y, in.YRes, modeY) * in.XRes];
+
+                             for(int x = 0; x < n; x++)
+                             {
+                               auto const& p = src[cols[x]];
+                               rg[y * n + x] = Complex(p.r, p.g);
+                               ba[y * n + x] = Complex(p.b, p.a);
+                             }
+                           }
+
+                           Fft2D(rg.data(), n, twiddles.data(), false, column.data());
+                           Fft2D(ba.data(), n, twiddles.data(), false, column.data());
+
+                           for(int i = 0; i < n * n; i++)
+                           {
+                             rg[i] *= spectrum[i];
+                             ba[i] *= spectrum[i];
+                           }
+
+                           Fft2D(rg.data(), n, twiddles.data(), true, column.data());
+                           Fft2D(ba.data(), n, twiddles.data(), true, column.data());
+
+                           // part of the tile inside 'r'
+                           auto const tx0 = max(x0, r.x0) - x0;
+                           auto const ty0 = max(y0, r.y0) - y0;
+                           auto const tx1 = min(x0 + tileW, r.x1) - x0;
+                           auto const ty1 = min(y0 + tileH, r.y1) - y0;
+
+                           for(int y = ty0; y < ty1; y++)
+                           {
+                             auto const out = &dest->Data[(y0 + y) * dest->XRes + x0];
+
+                             for(int x = tx0; x < tx1; x++)
+                               Store(out[x], Accu { rg[y * n + x].real(), rg[y * n + x].imag(), ba[y * n + x].real(),
+                                                    ba[y * n + x].imag() });
+                           }
+                         }
+                       };
+
+  ParallelForChunks(0, tilesX * tilesY, 1, convolveTiles);
+}
+}
+
+void Convolve(Texture* dest, const Texture& in, const float* kernel, int kw, int kh, int wrapMode, const Rect* region)
+{
+  assert(dest->SameSize(in));
+  assert(kw >= 1 && kh >= 1);
+
+  auto const r = region ? IntersectRect(*region, FullRect(*dest)) : FullRect(*dest);
+
+  if(IsEmptyRect(r))
+    return;
+
+  // pixels are read around the ones being written
+  Texture copy;
+  const Texture* src = &in;
+
+  if(dest == &in)
+  {
+    copy = in;
+    src = &copy;
+  }
+
+  auto const modeX = (wrapMode & ClampU) ? 1 : 0;
+  auto const modeY = (wrapMode & ClampV) ? 1 : 0;
+
+  vector<double> kx, ky;
+
+  if(SplitKernel(kernel, kw, kh, kx, ky))
+    ConvolveSeparable(dest, *src, kx, ky, modeX, modeY, r);
+  else if(kw * kh >= FftMinTaps)
+    ConvolveFft(dest, *src, kernel, kw, kh, modeX, modeY, r);
+  else
+    ConvolveDirect(dest, *src, kernel, kw, kh, modeX, modeY, r);
+}
 
-      // copy pixels back
-      src = buf1;
-      dst = &dest->Data[x];
+Rect ConvolveFootprint(const Texture& tex, Rect r, int kw, int kh, int wrapMode)
+{
+  return GrowRect(tex, r, kw / 2, kh / 2, wrapMode);
+}
+
+namespace
+{
+// Normalized gaussian, sampled at integer offsets up to 3 sigmas
+vector<float> GaussianAxis(sF32 sigma)
+{
+  const int radius = int(ceil(3 * sigma));
+  vector<float> r(2 * radius + 1);
+  double sum = 0;
+
+  for(int i = -radius; i <= radius; i++)
+    sum += r[i + radius] = sigma > 0 ? exp(-i * i / (2.0 * sigma * sigma)) : 1.0;
+
+  for(auto& w : r)
+    w /= sum;
+
+  return r;
+}
+
+// Weights of a preset (see KernelPreset), row by row
+vector<float> PresetKernel(KernelPreset preset, sF32 p0, sF32 p1, int& kw, int& kh)
+{
+  switch(preset)
+  {
+  case KernelGaussian:
+    {
+      auto const wx = GaussianAxis(clamp(p0, 0.0f, 64.0f));
+      auto const wy = GaussianAxis(clamp(p1, 0.0f, 64.0f));
+      kw = wx.size();
+      kh = wy.size();
 
-      for(int y = 0; y < YRes; y++)
+      vector<float> k(kw * kh);
+
+      for(int j = 0; j < kh; j++)
+        for(int i = 0; i < kw; i++)
+          k[j * kw + i] = wy[j] * wx[i];
+
+      return k;
+    }
+
+  case KernelSharpen:
+    kw = kh = 3;
+    return { 0, -p0, 0, -p0, 1 + 4 * p0, -p0, 0, -p0, 0 };
+
+  case KernelEmboss:
+    kw = kh = 3;
+    return { -p0, -p0, 0, -p0, 1, p0, 0, p0, p0 };
+
+  case KernelMotion:
+    {
+      // a line of 'length' pixels through the center, splatted bilinearly
+      auto const length = clamp(p0, 0.0f, 128.0f);
+      auto const radius = int(ceil(length / 2)) + 1;
+      kw = kh = 2 * radius + 1;
+
+      vector<float> k(kw * kh);
+      auto const count = int(length * 4) + 1;
+
+      for(int s = 0; s < count; s++)
       {
-        *dst = *src++;
-        dst += XRes;
+        auto const t = count > 1 ? length * (float(s) / (count - 1) - 0.5f) : 0.0f;
+        auto const x = radius + t * cos(p1);
+        auto const y = radius + t * sin(p1);
+        auto const ix = int(floor(x));
+        auto const iy = int(floor(y));
+        auto const fx = x - ix;
+        auto const fy = y - iy;
+
+        k[iy * kw + ix] += (1 - fx) * (1 - fy);
+        k[iy * kw + ix + 1] += fx * (1 - fy);
+        k[(iy + 1) * kw + ix] += (1 - fx) * fy;
+        k[(iy + 1) * kw + ix + 1] += fx * fy;
       }
+
+      for(auto& w : k)
+        w /= count;
+
+      return k;
     }
   }
+
+  kw = kh = 1;
+  return { 1 };
+}
 }
 
+void ConvolvePreset(Texture* dest, const Texture& in, KernelPreset preset, sF32 p0, sF32 p1, int wrapMode,
+                    const Rect* region)
+{
+  int kw, kh;
+  auto const kernel = PresetKernel(preset, p0, p1, kw, kh);
+  Convolve(dest, in, kernel.data(), kw, kh, wrapMode, region);
+}
+
+Rect ConvolvePresetFootprint(const Texture& tex, Rect r, KernelPreset preset, sF32 p0, sF32 p1, int wrapMode)
+{
+  int kw, kh;
+  PresetKernel(preset, p0, p1, kw, kh);
+  return ConvolveFootprint(tex, r, kw, kh, wrapMode);
+}
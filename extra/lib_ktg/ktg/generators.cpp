@@ -1,7 +1,8 @@
 #include <vector>
 #include <cmath>
-#include "gentexture.h"
+#include "ktg.h"
 #include "helpers.h"
+#include "parallel.h"
 
 // Perlin permutation table
 static uint16_t Ptable[4096];
@@ -153,7 +154,8 @@ static sF32 GNoise2(int x, int y, int maskx, int masky, int seed)
   return sum;
 }
 
-void Noise(Texture* dest, const Texture& grad, int freqX, int freqY, int oct, sF32 fadeoff, int seed, NoiseMode mode)
+void Noise(Texture* dest, const CompiledGradient& grad, int freqX, int freqY, int oct, sF32 fadeoff, int seed,
+           NoiseMode mode)
 {
   assert(oct > 0);
 
@@ -182,12 +184,14 @@ void Noise(Texture* dest, const Texture& grad, int freqX, int freqY, int oct, sF
   int offsY = (1 << (16 - dest->ShiftY + freqY)) >> 1;
 
   Pixel* out = dest->Data;
+  vector<int> row(dest->XRes);
 
-  for(int y = 0; y < dest->YRes; y++)
+  for(int y = 0; y < dest->YRes && !IsCancelled(); y++)
   {
     for(int x = 0; x < dest->XRes; x++)
     {
-      int n = offset;
+      int& n = row[x];
+      n = offset;
       sF32 s = scaling;
 
       int px = (x << (16 - dest->ShiftX + freqX)) + offsX;
@@ -210,15 +214,20 @@ void Noise(Texture* dest, const Texture& grad, int freqX, int freqY, int oct, sF
         mx += mx + 1;
         my += my + 1;
       }
-
-      grad.SampleGradient(*out, n);
-      out++;
     }
+
+    grad.Map(out, row.data(), dest->XRes);
+    out += dest->XRes;
   }
 }
 
-void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, sF32 orgx, sF32 orgy, sF32 ux, sF32 uy, sF32 vx,
-              sF32 vy, sF32 rectu, sF32 rectv)
+void Noise(Texture* dest, const Texture& grad, int freqX, int freqY, int oct, sF32 fadeoff, int seed, NoiseMode mode)
+{
+  Noise(dest, CompiledGradient(grad), freqX, freqY, oct, fadeoff, seed, mode);
+}
+
+void GlowRect(Texture* dest, const Texture& bgTex, const CompiledGradient& grad, sF32 orgx, sF32 orgy, sF32 ux,
+              sF32 uy, sF32 vx, sF32 vy, sF32 rectu, sF32 rectv, Rect* changed)
 {
   assert(dest->SameSize(bgTex));
 
@@ -239,7 +248,20 @@ void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, sF32 org
   sF32 detM = ux * vy - uy * vx;
 
   if(fabs(detM) * XRes * YRes < 0.25f) // smaller than a pixel? skip it.
+  {
+    if(changed)
+      *changed = EmptyRect();
+
     return;
+  }
+
+  if(changed)
+  {
+    *changed = Rect { minX, minY, maxX + 1, maxY + 1 };
+
+    if(IsEmptyRect(*changed))
+      *changed = EmptyRect();
+  }
 
   sF32 invM = (1 << 16) / detM;
   sF32 rmx = (minX + 0.5f) / XRes - orgx;
@@ -272,7 +294,7 @@ void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, sF32 org
 
         if(!du && !dv)
         {
-          grad.SampleGradient(col, 0);
+          grad.Sample(col, 0);
           out->CompositeROver(col);
         }
         else
@@ -283,7 +305,7 @@ void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, sF32 org
 
           if(dist < 1.0f)
           {
-            grad.SampleGradient(col, (1 << 24) * sqrt(dist));
+            grad.Sample(col, (1 << 24) * sqrt(dist));
             out->CompositeROver(col);
           }
         }
@@ -299,7 +321,187 @@ void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, sF32 org
   }
 }
 
-void Cells(Texture* dest, const Texture& grad, const CellCenter* centers, int nCenters, sF32 amp, CellMode mode)
+void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, sF32 orgx, sF32 orgy, sF32 ux, sF32 uy, sF32 vx,
+              sF32 vy, sF32 rectu, sF32 rectv, Rect* changed)
+{
+  GlowRect(dest, bgTex, CompiledGradient(grad), orgx, orgy, ux, uy, vx, vy, rectu, rectv, changed);
+}
+
+// Squared distance of the pixels with nothing inside
+static const float FarAway = 1e20f;
+
+// Lower envelope of the parabolas (q, f[q]): d[p] = min over q of (p - q)^2 + f[q]
+// (Felzenszwalb-Huttenlocher). 'v' and 'z' hold n and n + 1 values.
+static void DistanceTransform1D(float* d, const float* f, int n, int* v, double* z)
+{
+  int k = 0;
+  v[0] = 0;
+  z[0] = -1e30;
+  z[1] = 1e30;
+
+  auto intersection = [&] (int q, int p)
+                      {
+                        return ((f[q] + double(q) * q) - (f[p] + double(p) * p)) / (2.0 * (q - p));
+                      };
+
+  for(int q = 1; q < n; q++)
+  {
+    // parabolas hidden by the new one are removed (z[0] stops the loop)
+    double s = intersection(q, v[k]);
+
+    while(s <= z[k])
+    {
+      k--;
+      s = intersection(q, v[k]);
+    }
+
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = 1e30;
+  }
+
+  k = 0;
+
+  for(int q = 0; q < n; q++)
+  {
+    while(z[k + 1] < q)
+      k++;
+
+    d[q] = float(double(q - v[k]) * (q - v[k]) + f[v[k]]);
+  }
+}
+
+static int Channel(const Pixel& p, int channel)
+{
+  switch(channel)
+  {
+  case 0: return p.r;
+  case 1: return p.g;
+  case 2: return p.b;
+  default: return p.a;
+  }
+}
+
+// Transform of a line of 'n' values, circular if 'wrap'.
+// A circular line is transformed as three copies of itself, of which the
+// middle one is kept: no distance along it exceeds n / 2.
+// 'mem' holds at least 3 * n values.
+static void DistanceLine(float* line, int n, bool wrap, vector<float>& mem, vector<int>& v, vector<double>& z)
+{
+  const int count = wrap ? 3 * n : n;
+  auto const f = mem.data();
+  auto const d = mem.data() + count;
+
+  for(int i = 0; i < count; i++)
+    f[i] = line[i % n];
+
+  DistanceTransform1D(d, f, count, v.data(), z.data());
+
+  for(int i = 0; i < n; i++)
+    line[i] = d[wrap ? n + i : i];
+}
+
+void DistanceTransform(float* dist2, const Texture& shape, int channel, sF32 threshold, int wrapMode)
+{
+  auto const XRes = shape.XRes;
+  auto const YRes = shape.YRes;
+  auto const level = clamp<int>(threshold * 65535.0f + 0.5f, 0, 65535);
+
+  // rows: distance to the nearest inside pixel of the same row
+  auto rows = [&] (int first, int last)
+              {
+                vector<float> mem(6 * XRes);
+                vector<int> v(3 * XRes);
+                vector<double> z(3 * XRes + 1);
+
+                for(int y = first; y < last && !IsCancelled(); y++)
+                {
+                  auto const line = &dist2[y * XRes];
+                  auto const src = &shape.Data[y * XRes];
+
+                  for(int x = 0; x < XRes; x++)
+                    line[x] = Channel(src[x], channel) >= level ? 0 : FarAway;
+
+                  DistanceLine(line, XRes, !(wrapMode & ClampU), mem, v, z);
+                }
+              };
+
+  // columns, by blocks gathered from the rows
+  auto const block = max(1, Tuning().blurColumns);
+
+  auto columns = [&] (int first, int last)
+                 {
+                   vector<float> column(block * YRes), mem(6 * YRes);
+                   vector<int> v(3 * YRes);
+                   vector<double> z(3 * YRes + 1);
+
+                   for(int b = first; b < last && !IsCancelled(); b++)
+                   {
+                     auto const x0 = b * block;
+                     auto const count = min(block, XRes - x0);
+
+                     for(int y = 0; y < YRes; y++)
+                       for(int c = 0; c < count; c++)
+                         column[c * YRes + y] = dist2[y * XRes + x0 + c];
+
+                     for(int c = 0; c < count; c++)
+                       DistanceLine(&column[c * YRes], YRes, !(wrapMode & ClampV), mem, v, z);
+
+                     for(int y = 0; y < YRes; y++)
+                       for(int c = 0; c < count; c++)
+                         dist2[y * XRes + x0 + c] = column[c * YRes + y];
+                   }
+                 };
+
+  ParallelForChunks(0, YRes, Tuning().glowRows, rows);
+  ParallelForChunks(0, (XRes + block - 1) / block, 1, columns);
+}
+
+void DistanceGlow(Texture* dest, const Texture& bgTex, const Texture& shape, const CompiledGradient& grad, int channel,
+                  sF32 threshold, sF32 radius, int wrapMode)
+{
+  assert(dest->SameSize(bgTex));
+  assert(dest->SameSize(shape));
+
+  vector<float> dist2(shape.NPixels);
+  DistanceTransform(dist2.data(), shape, channel, threshold, wrapMode);
+
+  // copy background over (if we're not the background texture already)
+  if(dest != &bgTex)
+    *dest = bgTex;
+
+  if(radius <= 0)
+    return;
+
+  auto const scale = 1.0 / (double(radius) * dest->XRes);
+
+  auto glow = [&] (int first, int last)
+              {
+                for(int i = first * dest->XRes; i < last * dest->XRes; i++)
+                {
+                  auto const t = sqrt(double(dist2[i])) * scale;
+
+                  if(t < 1)
+                  {
+                    Pixel col;
+                    grad.Sample(col, int((1 << 24) * t));
+                    dest->Data[i].CompositeROver(col);
+                  }
+                }
+              };
+
+  ParallelForChunks(0, dest->YRes, Tuning().glowRows, glow);
+}
+
+void DistanceGlow(Texture* dest, const Texture& bgTex, const Texture& shape, const Texture& grad, int channel,
+                  sF32 threshold, sF32 radius, int wrapMode)
+{
+  DistanceGlow(dest, bgTex, shape, CompiledGradient(grad), channel, threshold, radius, wrapMode);
+}
+
+void Cells(Texture* dest, const CompiledGradient& grad, const CellCenter* centers, int nCenters, sF32 amp,
+           CellMode mode)
 {
   assert(((mode & 1) == 0) ? nCenters >= 1 : nCenters >= 2);
 
@@ -310,9 +512,7 @@ void Cells(Texture* dest, const Texture& grad, const CellCenter* centers, int nC
     int node;
   };
 
-  Pixel* out = dest->Data;
-
-  vector<CellPoint> points(nCenters);
+  vector<CellPoint> sortedPoints(nCenters);
 
   // convert cell center coordinates to fixed point
   static const int scaleF = 14; // should be <=14 for 32-bit ints.
@@ -320,116 +520,509 @@ void Cells(Texture* dest, const Texture& grad, const CellCenter* centers, int nC
 
   for(int i = 0; i < nCenters; i++)
   {
-    points[i].x = int(centers[i].x * scale + 0.5f) & (scale - 1);
-    points[i].y = int(centers[i].y * scale + 0.5f) & (scale - 1);
-    points[i].distY = -1;
-    points[i].node = i;
+    sortedPoints[i].x = int(centers[i].x * scale + 0.5f) & (scale - 1);
+    sortedPoints[i].y = int(centers[i].y * scale + 0.5f) & (scale - 1);
+    sortedPoints[i].distY = -1;
+    sortedPoints[i].node = i;
   }
 
   int stepX = 1 << (scaleF - dest->ShiftX);
   int stepY = 1 << (scaleF - dest->ShiftY);
-  int yc = stepY >> 1;
 
   amp = amp * (1 << 24);
 
-  for(int y = 0; y < dest->YRes; y++)
-  {
-    int xc = stepX >> 1;
+  // sort the points by y, then by index
+  sort(sortedPoints.begin(), sortedPoints.end(), [] (const CellPoint& a, const CellPoint& b)
+       {
+         return a.y != b.y ? a.y < b.y : a.node < b.node;
+       });
+
+  auto rowDistance = [&] (int py, int yc)
+                     {
+                       int dy = (yc - py) & (scale - 1);
+                       return sSquare(min(dy, scale - dy));
+                     };
+
+  auto cellRows = [&] (int first, int last)
+                  {
+                    // The points of the current row, by y-distance, closest first.
+                    // Ties are broken by the y-distance to the previous row, then by
+                    // index: this is the order a stable sort of each row, starting
+                    // from the order of the previous row, would give.
+                    // Walking 'sortedPoints' away from the row center, in both
+                    // directions, yields two lists sorted by distance: they are merged
+                    // lazily, as far as the pixels of the row need.
+                    vector<CellPoint> points(nCenters);
+                    int ordered = 0;
+
+                    int y, yc, start;
+                    int ahead, behind;
+                    vector<CellPoint> run; // points behind the center, with the same y
+                    int runPos = 0;
+
+                    auto startRow = [&] (int row)
+                                    {
+                                      y = row;
+                                      yc = (stepY >> 1) + y * stepY;
+
+                                      start = lower_bound(sortedPoints.begin(), sortedPoints.end(), yc,
+                                                          [] (const CellPoint& p, int value)
+                                                          {
+                                                            return p.y < value;
+                                                          }) - sortedPoints.begin();
+
+                                      ordered = 0;
+                                      ahead = start;
+                                      behind = start + nCenters;
+                                      run.clear();
+                                      runPos = 0;
+                                    };
+
+                    // appends the next closest point to 'points'
+                    auto more = [&] ()
+                                {
+                                  // next point at or after the center (wrapping around)
+                                  CellPoint next;
+                                  bool hasNext = false;
+
+                                  if(ahead < start + nCenters)
+                                  {
+                                    next = sortedPoints[ahead % nCenters];
+                                    int dy = (next.y - yc) & (scale - 1);
+                                    next.distY = sSquare(dy);
+                                    hasNext = dy <= scale / 2;
+                                  }
+
+                                  // next run of points before the center, in index order
+                                  if(runPos == int(run.size()) && behind > start)
+                                  {
+                                    run.clear();
+                                    runPos = 0;
+
+                                    int const runY = sortedPoints[(behind - 1) % nCenters].y;
+                                    int const dy = (yc - runY) & (scale - 1);
+
+                                    if(dy > 0 && dy < scale / 2)
+                                    {
+                                      int runStart = behind - 1;
+
+                                      while(runStart > start && sortedPoints[(runStart - 1) % nCenters].y == runY)
+                                        runStart--;
+
+                                      for(int i = runStart; i < behind; i++)
+                                      {
+                                        CellPoint p = sortedPoints[i % nCenters];
+                                        p.distY = sSquare(dy);
+                                        run.push_back(p);
+                                      }
+
+                                      behind = runStart;
+                                    }
+                                    else
+                                      behind = start;
+                                  }
+
+                                  if(runPos < int(run.size()))
+                                  {
+                                    const CellPoint& before = run[runPos];
+                                    bool beforeFirst = !hasNext;
+
+                                    if(hasNext && before.distY != next.distY)
+                                      beforeFirst = before.distY < next.distY;
+                                    else if(hasNext)
+                                    {
+                                      int prevA = y > 0 ? rowDistance(before.y, yc - stepY) : 0;
+                                      int prevB = y > 0 ? rowDistance(next.y, yc - stepY) : 0;
+                                      beforeFirst = prevA != prevB ? prevA < prevB : before.node < next.node;
+                                    }
+
+                                    if(beforeFirst)
+                                    {
+                                      points[ordered++] = before;
+                                      runPos++;
+                                      return true;
+                                    }
+                                  }
+
+                                  if(!hasNext)
+                                    return false;
+
+                                  points[ordered++] = next;
+                                  ahead++;
+                                  return true;
+                                };
+
+                    for(int row = first; row < last && !IsCancelled(); row++)
+                    {
+                      Pixel* out = dest->Data + row * dest->XRes;
+                      int xc = stepX >> 1;
+
+                      startRow(row);
+
+                      int best, best2;
+                      int besti, best2i;
+
+                      best = best2 = sSquare(scale);
+                      besti = best2i = -1;
+
+                      for(int x = 0; x < dest->XRes; x++)
+                      {
+                        int t, dx;
+
+                        // update "best point" stats
+                        if(besti != -1 && best2i != -1)
+                        {
+                          dx = (xc - points[besti].x) & (scale - 1);
+                          best = sSquare(min(dx, scale - dx)) + points[besti].distY;
+
+                          dx = (xc - points[best2i].x) & (scale - 1);
+                          best2 = sSquare(min(dx, scale - dx)) + points[best2i].distY;
+
+                          if(best2 < best)
+                          {
+                            swap(best, best2);
+                            swap(besti, best2i);
+                          }
+                        }
+
+                        // search for better points
+                        for(int i = 0; (i < ordered || more()) && best2 > points[i].distY; i++)
+                        {
+                          int dx = (xc - points[i].x) & (scale - 1);
+                          dx = sSquare(min(dx, scale - dx));
+
+                          int dist = dx + points[i].distY;
+
+                          if(dist < best)
+                          {
+                            best2 = best;
+                            best2i = besti;
+                            best = dist;
+                            besti = i;
+                          }
+                          else if(dist > best && dist < best2)
+                          {
+                            best2 = dist;
+                            best2i = i;
+                          }
+                        }
+
+                        // color the pixel accordingly
+                        sF32 d0 = sqrt(best) / scale;
+
+                        if((mode & 1) == CellInner) // inner
+                          t = clamp<int>(d0 * amp, 0, 1 << 24);
+                        else // outer
+                        {
+                          sF32 d1 = sqrt(best2) / scale;
+
+                          if(d0 + d1 > 0.0f)
+                            t = clamp<int>(d0 / (d1 + d0) * 2 * amp, 0, 1 << 24);
+                          else
+                            t = 0;
+                        }
+
+                        grad.Sample(*out, t);
+                        out[0].CompositeMulC(centers[points[besti].node].color);
+
+                        out++;
+                        xc += stepX;
+                      }
+                    }
+                  };
+
+  ParallelForChunks(0, dest->YRes, Tuning().cellsRows, cellRows);
+}
 
-    // calculate new y distances
-    for(int i = 0; i < nCenters; i++)
-    {
-      int dy = (yc - points[i].y) & (scale - 1);
-      points[i].distY = sSquare(min(dy, scale - dy));
-    }
+void Cells(Texture* dest, const Texture& grad, const CellCenter* centers, int nCenters, sF32 amp, CellMode mode)
+{
+  Cells(dest, CompiledGradient(grad), centers, nCenters, amp, mode);
+}
 
-    // (insertion) sort by y-distance
-    for(int i = 1; i < nCenters; i++)
-    {
-      CellPoint v = points[i];
-      int j = i;
+// Small deterministic generator, so a given seed always yields the same points
+struct Random
+{
+  Random(uint32_t seed) : state((seed * 2654435761u) | 1)
+  {
+  }
 
-      while(j && points[j - 1].distY > v.distY)
-      {
-        points[j] = points[j - 1];
-        j--;
-      }
+  uint32_t Next()
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
 
-      points[j] = v;
-    }
+  // uniform in [0;1)
+  sF32 NextFloat()
+  {
+    return (Next() >> 8) / sF32(1 << 24);
+  }
+
+  uint32_t state;
+};
 
-    int best, best2;
-    int besti, best2i;
+struct PoissonPoint
+{
+  sF32 x, y;
+};
+
+// Saturated blue-noise point set of radius 'radius' on the unit torus
+// (Bridson's algorithm).
+// The torus is split in tiles, filled in 4 phases: the tiles of a phase are
+// a whole tile apart, so they don't interact and get filled in parallel.
+// Each tile grows from the points its neighbours left on its border.
+// The points only depend on 'seed', not on the number of threads.
+static vector<PoissonPoint> FillTorus(sF32 radius, int seed)
+{
+  // background grid: cells small enough to hold at most one point.
+  static const int MaxGridSize = 4096;
+  radius = max(radius, sqrt(2.0f) / MaxGridSize);
+  const int gridSize = int(ceil(sqrt(2.0f) / radius));
+  const sF32 r2 = radius * radius;
+
+  // The grid has a border of 'pad' cells on each side, holding wrapped
+  // copies of the points: this way, the neighbour search needs no modulo.
+  static const int pad = 2;
+  const int stride = gridSize + 2 * pad;
+
+  // empty cells hold a point far away
+  vector<PoissonPoint> grid(stride * stride, PoissonPoint { 1e9f, 1e9f });
+
+  auto cellOf = [&](sF32 v)
+                {
+                  return min(int(v * gridSize), gridSize - 1);
+                };
+
+  // the 5x5 cells around a point, nearest first: most rejected candidates
+  // are rejected by the first few ones.
+  int neighbours[25];
+
+  for(int i = 0, ring = 0; ring <= 8; ring++)
+    for(int dy = -2; dy <= 2; dy++)
+      for(int dx = -2; dx <= 2; dx++)
+        if(dx * dx + dy * dy == ring)
+          neighbours[i++] = dy * stride + dx;
+
+  auto isFarEnough = [&](sF32 x, sF32 y, int cx, int cy)
+                     {
+                       const PoissonPoint* center = &grid[(cy + pad) * stride + cx + pad];
+
+                       for(auto offset : neighbours)
+                       {
+                         const PoissonPoint& cell = center[offset];
+
+                         if(sSquare(cell.x - x) + sSquare(cell.y - y) < r2)
+                           return false;
+                       }
+
+                       return true;
+                     };
+
+  auto store = [&](sF32 x, sF32 y)
+               {
+                 const int cx = cellOf(x);
+                 const int cy = cellOf(y);
+
+                 for(int oy = -1; oy <= 1; oy++)
+                 {
+                   for(int ox = -1; ox <= 1; ox++)
+                   {
+                     const int tx = cx + ox * gridSize;
+                     const int ty = cy + oy * gridSize;
+
+                     if(tx >= -pad && tx < gridSize + pad && ty >= -pad && ty < gridSize + pad)
+                       grid[(ty + pad) * stride + tx + pad] = PoissonPoint { x + ox, y + oy };
+                   }
+                 }
+               };
+
+  // Candidates evenly spread on a circle just outside the exclusion disk
+  // (Roberts' variant of Bridson's algorithm): fewer tries, denser packing.
+  // Each point sweeps the circle once, starting at a random angle.
+  static const int MaxTries = 12;
+  sF32 dirX[MaxTries], dirY[MaxTries];
+
+  for(int i = 0; i < MaxTries; i++)
+  {
+    dirX[i] = cos(2 * M_PI * i / MaxTries);
+    dirY[i] = sin(2 * M_PI * i / MaxTries);
+  }
 
-    best = best2 = sSquare(scale);
-    besti = best2i = -1;
+  const sF32 dist = radius * 1.0001f;
+
+  // An even number of tiles on each axis, so the phases also alternate
+  // across the wrap-around. Tiles are at least 32 cells wide, while a point
+  // only sees 2 cells around it.
+  const int tiles = 2 * clamp(gridSize / 64, 1, 16);
+
+  auto tileStart = [&](int t)
+                   {
+                     return t * gridSize / tiles;
+                   };
+
+  vector<vector<PoissonPoint>> tilePoints(tiles * tiles);
+
+  auto fillTile = [&](int tx, int ty)
+                  {
+                    const int x0 = tileStart(tx), x1 = tileStart(tx + 1);
+                    const int y0 = tileStart(ty), y1 = tileStart(ty + 1);
+
+                    Random rand(uint32_t(seed) * 7919u + ty * tiles + tx);
+
+                    struct Active
+                    {
+                      sF32 x, y;
+                      sF32 c, s; // rotation of the candidates
+                      int next; // next candidate
+                    };
+
+                    vector<Active> active;
+
+                    auto activate = [&](sF32 x, sF32 y)
+                                    {
+                                      const sF32 angle = rand.NextFloat() * sF32(2 * M_PI);
+                                      active.push_back(Active { x, y, dist * cosf(angle), dist * sinf(angle), 0 });
+                                    };
+
+                    // the points of the neighbour tiles around this one (or their copies)
+                    for(int cy = y0 - pad; cy < y1 + pad; cy++)
+                    {
+                      for(int cx = x0 - pad; cx < x1 + pad; cx++)
+                      {
+                        const auto& cell = grid[(cy + pad) * stride + cx + pad];
+
+                        // back from the copies to the torus
+                        if(cell.x != 1e9f)
+                          activate(cell.x - floorf(cell.x), cell.y - floorf(cell.y));
+                      }
+                    }
+
+                    // the first tiles start from a random point
+                    if(active.empty())
+                    {
+                      const sF32 x = (x0 + rand.NextFloat() * (x1 - x0)) / gridSize;
+                      const sF32 y = (y0 + rand.NextFloat() * (y1 - y0)) / gridSize;
+                      store(x, y);
+                      tilePoints[ty * tiles + tx].push_back(PoissonPoint { x, y });
+                      activate(x, y);
+                    }
+
+                    // always expanding from the newest point keeps the grid accesses local
+                    while(!active.empty())
+                    {
+                      const int i = active.back().next++;
+
+                      // this point is surrounded: retire it
+                      if(i == MaxTries)
+                      {
+                        active.pop_back();
+                        continue;
+                      }
+
+                      const Active org = active.back();
+                      sF32 x = org.x + org.c * dirX[i] - org.s * dirY[i];
+                      sF32 y = org.y + org.s * dirX[i] + org.c * dirY[i];
+
+                      // candidates are less than 0.5 away: wrap them once at most
+                      x += x < 0 ? 1.0f : x >= 1.0f ? -1.0f : 0.0f;
+                      y += y < 0 ? 1.0f : y >= 1.0f ? -1.0f : 0.0f;
+
+                      // rounding can bring a tiny negative value to 1
+                      if(x >= 1.0f || y >= 1.0f)
+                        continue;
+
+                      const int cx = cellOf(x);
+                      const int cy = cellOf(y);
+
+                      if(cx < x0 || cx >= x1 || cy < y0 || cy >= y1 || !isFarEnough(x, y, cx, cy))
+                        continue;
+
+                      store(x, y);
+                      tilePoints[ty * tiles + tx].push_back(PoissonPoint { x, y });
+                      activate(x, y);
+                    }
+                  };
+
+  const int half = tiles / 2;
+
+  for(int phase = 0; phase < 4; phase++)
+  {
+    ParallelFor(0, half * half, 1, [&] (int k)
+                {
+                  fillTile(2 * (k % half) + (phase & 1), 2 * (k / half) + (phase >> 1));
+                });
+  }
 
-    for(int x = 0; x < dest->XRes; x++)
-    {
-      int t, dx;
+  vector<PoissonPoint> points;
 
-      // update "best point" stats
-      if(besti != -1 && best2i != -1)
-      {
-        dx = (xc - points[besti].x) & (scale - 1);
-        best = sSquare(min(dx, scale - dx)) + points[besti].distY;
+  for(auto& p : tilePoints)
+    points.insert(points.end(), p.begin(), p.end());
 
-        dx = (xc - points[best2i].x) & (scale - 1);
-        best2 = sSquare(min(dx, scale - dx)) + points[best2i].distY;
+  return points;
+}
 
-        if(best2 < best)
-        {
-          swap(best, best2);
-          swap(besti, best2i);
-        }
-      }
+// Blue-noise point set on the unit torus.
+// Points are at least 'minDist' apart, and wrap around like 'Cells' does.
+// The radius also grows as 'maxCount' decreases, so that the points cover
+// the whole domain. Returns the number of generated points (at most
+// 'maxCount').
+int PoissonDisk(CellCenter* centers, int maxCount, sF32 minDist, int seed)
+{
+  if(maxCount <= 0)
+    return 0;
 
-      // search for better points
-      for(int i = 0; i<nCenters && best2> points[i].distY; i++)
-      {
-        int dx = (xc - points[i].x) & (scale - 1);
-        dx = sSquare(min(dx, scale - dx));
+  // A saturated set of radius r holds about 0.8/r^2 points: slightly
+  // larger radii keep most sets under 'maxCount'. Those which aren't are
+  // generated again, a bit sparser.
+  sF32 radius = clamp(max(minDist, sqrt(0.82f / maxCount)), 0.0f, 0.5f);
+  auto points = FillTorus(radius, seed);
 
-        int dist = dx + points[i].distY;
+  while(int(points.size()) > maxCount && radius < 0.5f)
+  {
+    radius = min(radius * 1.02f, 0.5f);
+    points = FillTorus(radius, seed);
+  }
 
-        if(dist < best)
-        {
-          best2 = best;
-          best2i = besti;
-          best = dist;
-          besti = i;
-        }
-        else if(dist > best && dist < best2)
-        {
-          best2 = dist;
-          best2i = i;
-        }
-      }
+  const int count = min(int(points.size()), maxCount);
 
-      // color the pixel accordingly
-      sF32 d0 = sqrt(best) / scale;
+  for(int i = 0; i < count; i++)
+  {
+    centers[i].x = points[i].x;
+    centers[i].y = points[i].y;
+    centers[i].color.Init(0xffffffff);
+  }
 
-      if((mode & 1) == CellInner) // inner
-        t = clamp<int>(d0 * amp, 0, 1 << 24);
-      else // outer
-      {
-        sF32 d1 = sqrt(best2) / scale;
+  return count;
+}
 
-        if(d0 + d1 > 0.0f)
-          t = clamp<int>(d0 / (d1 + d0) * 2 * amp, 0, 1 << 24);
-        else
-          t = 0;
-      }
+void Voronoi(Texture* dest, sF32 intensity, int maxCount, sF32 minDist, int seed)
+{
+  // The densest point set 'PoissonDisk' can generate holds about 6M points.
+  static const int MaxCenters = 1 << 22;
+  maxCount = clamp(maxCount, 1, MaxCenters);
 
-      grad.SampleGradient(*out, t);
-      out[0].CompositeMulC(centers[points[besti].node].color);
+  vector<CellCenter> centers(maxCount);
+  const int count = PoissonDisk(centers.data(), maxCount, minDist, 123 + seed);
 
-      out++;
-      xc += stepX;
-    }
+  // random gray level for each cell
+  Random rand(456 + seed);
+  const uint32_t maxIntens = max(1, int(intensity * 256));
 
-    yc += stepY;
+  for(int i = 0; i < count; i++)
+  {
+    const uint16_t intens = rand.Next() % maxIntens;
+    auto& color = centers[i].color;
+    color.r = color.g = color.b = (intens << 8) | intens;
+    color.a = 65535;
   }
+
+  Texture grad(2, 1);
+  grad.Data[0].Init(0xffffffff);
+  grad.Data[1].Init(0x00000000);
+
+  Cells(dest, grad, centers.data(), count, 0.0f, CellInner);
 }
 
 static int static_this()
@@ -138,6 +138,7 @@ Texture::~Texture()
 void Texture::Free()
 {
   delete[] Data;
+  Data = nullptr;
 }
 
 void Texture::Init(int xres, int yres)
@@ -251,3 +252,138 @@ void Texture::SampleGradient(Pixel& result, int x) const
   result.Lerp(fx, Data[x0], Data[x1]);
 }
 
+/****************************************************************************/
+/***                                                                      ***/
+/***   Compiled gradient                                                  ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+CompiledGradient::CompiledGradient()
+{
+  Segments = nullptr;
+  Shift = 0;
+}
+
+CompiledGradient::CompiledGradient(const Texture& grad)
+{
+  Segments = nullptr;
+  Init(grad);
+}
+
+CompiledGradient::~CompiledGradient()
+{
+  Free();
+}
+
+void CompiledGradient::__ctor(const Texture& grad)
+{
+  Segments = nullptr;
+  Init(grad);
+}
+
+void CompiledGradient::Free()
+{
+  delete[] Segments;
+  Segments = nullptr;
+}
+
+void CompiledGradient::Init(const Texture& grad)
+{
+  Free();
+
+  Shift = grad.ShiftX;
+  Segments = new GradientSegment[grad.XRes];
+
+  for(int i = 0; i < grad.XRes; i++)
+  {
+    // same neighbour as SampleGradient (wraps around on the last texel)
+    const Pixel& p0 = grad.Data[i];
+    const Pixel& p1 = grad.Data[(i + 1) & (grad.XRes - 1)];
+    GradientSegment& s = Segments[i];
+
+    s.Base[0] = p0.r;
+    s.Base[1] = p0.g;
+    s.Base[2] = p0.b;
+    s.Base[3] = p0.a;
+
+    s.Delta[0] = p1.r - p0.r;
+    s.Delta[1] = p1.g - p0.g;
+    s.Delta[2] = p1.b - p0.b;
+    s.Delta[3] = p1.a - p0.a;
+  }
+}
+
+void CompiledGradient::Map(Pixel* out, const int* x, int n) const
+{
+  for(int i = 0; i < n; i++)
+    Sample(out[i], x[i]);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Rect                                                               ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+Rect EmptyRect()
+{
+  return Rect { 0, 0, 0, 0 };
+}
+
+Rect FullRect(const Texture& tex)
+{
+  return Rect { 0, 0, tex.XRes, tex.YRes };
+}
+
+bool IsEmptyRect(Rect r)
+{
+  return r.x0 >= r.x1 || r.y0 >= r.y1;
+}
+
+Rect IntersectRect(Rect a, Rect b)
+{
+  Rect r { max(a.x0, b.x0), max(a.y0, b.y0), min(a.x1, b.x1), min(a.y1, b.y1) };
+
+  if(IsEmptyRect(r))
+    return EmptyRect();
+
+  return r;
+}
+
+Rect UnionRect(Rect a, Rect b)
+{
+  if(IsEmptyRect(a))
+    return b;
+
+  if(IsEmptyRect(b))
+    return a;
+
+  return Rect { min(a.x0, b.x0), min(a.y0, b.y0), max(a.x1, b.x1), max(a.y1, b.y1) };
+}
+
+// Grows the range [lo;hi[ by 'delta' on each side, within [0;size[
+static void GrowRange(int& lo, int& hi, int delta, int size, bool clampMode)
+{
+  lo -= delta;
+  hi += delta;
+
+  if(!clampMode && (lo < 0 || hi > size))
+  {
+    lo = 0;
+    hi = size;
+  }
+
+  lo = max(lo, 0);
+  hi = min(hi, size);
+}
+
+Rect GrowRect(const Texture& tex, Rect r, int dx, int dy, int wrapMode)
+{
+  if(IsEmptyRect(r))
+    return r;
+
+  Rect result = r;
+  GrowRange(result.x0, result.x1, dx, tex.XRes, wrapMode & ClampU);
+  GrowRange(result.y0, result.y1, dy, tex.YRes, wrapMode & ClampV);
+  return result;
+}
@@ -26,6 +26,13 @@ struct CellCenter
   Pixel color;
 };
 
+// Rect. Range of pixels [x0;x1[ x [y0;y1[.
+// Used to track which part of a texture an operation changed.
+struct Rect
+{
+  int x0, y0, x1, y1;
+};
+
 // LinearInput. One input for "linear combine".
 struct Texture;
 
@@ -57,6 +64,24 @@ enum DeriveOp
   DeriveNormals,
 };
 
+// Morphology operations, over a rectangular window
+enum MorphOp
+{
+  MorphDilate = 0,      // maximum
+  MorphErode,           // minimum
+  MorphOpen,            // erode, then dilate
+  MorphClose,           // dilate, then erode
+};
+
+// Kernel presets (see ConvolvePreset)
+enum KernelPreset
+{
+  KernelGaussian = 0,   // p0, p1: sigma in x and y, in pixels
+  KernelSharpen,        // p0: amount
+  KernelEmboss,         // p0: strength
+  KernelMotion,         // p0: length in pixels, p1: angle in radians
+};
+
 // Combine operations
 enum CombineOp
 {
@@ -143,3 +168,58 @@ struct Texture
   void SampleGradient(Pixel& result, int x) const;
 };
 
+// CompiledGradient. A gradient texture expanded into one table entry per
+// texel (base color and delta to the next texel): mapping a scalar to a
+// color is then one lookup and one multiply-add per channel.
+// Gives the same results as Texture::SampleGradient.
+struct GradientSegment
+{
+  int Base[4];   // r, g, b, a
+  int Delta[4];
+};
+
+struct CompiledGradient
+{
+  GradientSegment* Segments;
+  int Shift;     // log2(number of segments)
+
+  CompiledGradient();
+  CompiledGradient(const Texture& grad);
+  CompiledGradient(const CompiledGradient &) = delete;
+  ~CompiledGradient();
+  void __ctor(const Texture& grad);
+  void Free();
+
+  void Init(const Texture& grad);
+
+  // x is 1.7.24 fixed point, clamped to [0;1]
+  void Sample(Pixel& result, int x) const;
+
+  // Maps 'n' scalars to colors
+  void Map(Pixel* out, const int* x, int n) const;
+};
+
+inline void CompiledGradient::Sample(Pixel& result, int x) const
+{
+  x = x < 0 ? 0 : x > (1 << 24) ? (1 << 24) : x;
+  x -= x >> Shift; // x=(1<<24) -> Take rightmost pixel
+
+  const GradientSegment& s = Segments[x >> (24 - Shift)];
+  int fx = uint32_t(x << (Shift + 8)) >> 16;
+
+  result.r = s.Base[0] + ((fx * s.Delta[0]) >> 16);
+  result.g = s.Base[1] + ((fx * s.Delta[1]) >> 16);
+  result.b = s.Base[2] + ((fx * s.Delta[2]) >> 16);
+  result.a = s.Base[3] + ((fx * s.Delta[3]) >> 16);
+}
+
+// Rect helpers
+Rect EmptyRect();
+Rect FullRect(const Texture& tex);
+bool IsEmptyRect(Rect r);
+Rect IntersectRect(Rect a, Rect b);
+Rect UnionRect(Rect a, Rect b);
+
+// Grows 'r' by 'dx' (resp. 'dy') pixels on each side, following the
+// wrap/clamp mode. A rect wrapping around an edge is extended to the whole axis.
+Rect GrowRect(const Texture& tex, Rect r, int dx, int dy, int wrapMode);
@@ -0,0 +1,259 @@
+/**
+ * @file heightmesh.cpp
+ * @brief Simplified meshes from heightmaps
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+// Right-triangulated irregular network: the square grid is cut into two
+// right triangles, and each triangle is recursively split in two by the
+// midpoint of its hypotenuse, down to the grid resolution.
+//
+// The error of a hypotenuse midpoint is the largest distance between the
+// heightmap and the plane of the two triangles sharing the hypotenuse, maxed
+// with the errors of the midpoints of all the triangles below them.
+// A triangle is split when the error of its hypotenuse midpoint is too
+// large, so the triangles left all fit within the error. As the errors
+// decrease down the tree, splitting a triangle implies splitting its
+// neighbour on the hypotenuse, which keeps the mesh free of cracks.
+
+#include "heightmesh.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace std;
+
+HeightMesh::HeightMesh()
+{
+  Vertices = nullptr;
+  NumVertices = 0;
+  Indices = nullptr;
+  NumTriangles = 0;
+}
+
+HeightMesh::~HeightMesh()
+{
+  Free();
+}
+
+void HeightMesh::Free()
+{
+  delete[] Vertices;
+  delete[] Indices;
+  Vertices = nullptr;
+  Indices = nullptr;
+  NumVertices = 0;
+  NumTriangles = 0;
+}
+
+namespace
+{
+struct Point
+{
+  int x, y;
+};
+
+Point Middle(Point a, Point b)
+{
+  return Point { (a.x + b.x) / 2, (a.y + b.y) / 2 };
+}
+
+struct Triangulator
+{
+  Triangulator(const Texture& tex)
+  {
+    // the grid is square: the smaller dimension of the texture gets stretched
+    const int size = max(tex.XRes, tex.YRes);
+    gridSize = size + 1;
+
+    heights.resize(gridSize * gridSize);
+    errors.assign(gridSize * gridSize, 0.0f);
+
+    for(int y = 0; y < gridSize; ++y)
+    {
+      const int ty = int(int64_t(y) * tex.YRes / size) % tex.YRes;
+
+      for(int x = 0; x < gridSize; ++x)
+      {
+        const int tx = int(int64_t(x) * tex.XRes / size) % tex.XRes;
+        heights[y * gridSize + x] = tex.Data[ty * tex.XRes + tx].r / 65535.0f;
+      }
+    }
+  }
+
+  int Index(Point p) const
+  {
+    return p.y * gridSize + p.x;
+  }
+
+  // Triangles whose legs are one texel long have no midpoint
+  static bool IsLeaf(Point a, Point c)
+  {
+    return abs(a.x - c.x) + abs(a.y - c.y) <= 1;
+  }
+
+  // Largest distance between the heights inside the triangle and its plane
+  float PlaneError(Point a, Point b, Point c) const
+  {
+    const int x0 = min({ a.x, b.x, c.x });
+    const int x1 = max({ a.x, b.x, c.x });
+    const int y0 = min({ a.y, b.y, c.y });
+    const int y1 = max({ a.y, b.y, c.y });
+
+    // barycentric coordinates, scaled by 'det'
+    const int det = (b.y - c.y) * (a.x - c.x) + (c.x - b.x) * (a.y - c.y);
+    const int sign = det > 0 ? 1 : -1;
+    const float ha = heights[Index(a)] / det;
+    const float hb = heights[Index(b)] / det;
+    const float hc = heights[Index(c)] / det;
+
+    float error = 0;
+
+    for(int y = y0; y <= y1; ++y)
+    {
+      for(int x = x0; x <= x1; ++x)
+      {
+        const int l1 = (b.y - c.y) * (x - c.x) + (c.x - b.x) * (y - c.y);
+        const int l2 = (c.y - a.y) * (x - c.x) + (a.x - c.x) * (y - c.y);
+        const int l3 = det - l1 - l2;
+
+        if(l1 * sign < 0 || l2 * sign < 0 || l3 * sign < 0)
+          continue;
+
+        const float plane = l1 * ha + l2 * hb + l3 * hc;
+        error = max(error, fabs(plane - heights[y * gridSize + x]));
+      }
+    }
+
+    return error;
+  }
+
+  // Visits the triangles of the tree at 'depth' below (a, b, c), where
+  // (a, b) is the hypotenuse.
+  void ComputeErrors(Point a, Point b, Point c, int depth)
+  {
+    if(IsLeaf(a, c))
+      return; // can't be split: no midpoint
+
+    const auto m = Middle(a, b);
+
+    if(depth > 0)
+    {
+      ComputeErrors(c, a, m, depth - 1);
+      ComputeErrors(b, c, m, depth - 1);
+      return;
+    }
+
+    float error = PlaneError(a, b, c);
+
+    if(!IsLeaf(c, m))
+    {
+      error = max(error, errors[Index(Middle(c, a))]);
+      error = max(error, errors[Index(Middle(b, c))]);
+    }
+
+    errors[Index(m)] = max(errors[Index(m)], error);
+  }
+
+  // Propagates the errors from the finest triangles up to the roots. Both
+  // triangles sharing a hypotenuse are done before their parents.
+  void ComputeErrors()
+  {
+    const Point p00 { 0, 0 };
+    const Point p01 { 0, gridSize - 1 };
+    const Point p10 { gridSize - 1, 0 };
+    const Point p11 { gridSize - 1, gridSize - 1 };
+
+    // the legs are halved every two levels, down to one texel
+    int maxDepth = 0;
+
+    while((1 << (maxDepth / 2)) < gridSize - 1)
+      maxDepth += 2;
+
+    for(int depth = maxDepth; depth >= 0; --depth)
+    {
+      ComputeErrors(p00, p11, p10, depth);
+      ComputeErrors(p11, p00, p01, depth);
+    }
+  }
+
+  int AddVertex(Point p)
+  {
+    auto& index = vertexIndices[Index(p)];
+
+    if(index < 0)
+    {
+      index = int(vertices.size() / 3);
+      vertices.push_back(float(p.x) / (gridSize - 1));
+      vertices.push_back(float(p.y) / (gridSize - 1));
+      vertices.push_back(heights[Index(p)]);
+    }
+
+    return index;
+  }
+
+  void Emit(Point a, Point b, Point c, float maxError)
+  {
+    const auto m = Middle(a, b);
+
+    if(!IsLeaf(a, c) && errors[Index(m)] > maxError)
+    {
+      Emit(c, a, m, maxError);
+      Emit(b, c, m, maxError);
+      return;
+    }
+
+    indices.push_back(AddVertex(a));
+    indices.push_back(AddVertex(b));
+    indices.push_back(AddVertex(c));
+  }
+
+  void Emit(float maxError)
+  {
+    vertexIndices.assign(gridSize * gridSize, -1);
+
+    const Point p00 { 0, 0 };
+    const Point p01 { 0, gridSize - 1 };
+    const Point p10 { gridSize - 1, 0 };
+    const Point p11 { gridSize - 1, gridSize - 1 };
+
+    Emit(p00, p11, p10, maxError);
+    Emit(p11, p00, p01, maxError);
+  }
+
+  int gridSize;
+  vector<float> heights;
+  vector<float> errors;
+
+  vector<int> vertexIndices;
+  vector<float> vertices;
+  vector<int> indices;
+};
+}
+
+void HeightmapMesh(HeightMesh* mesh, const Texture& tex, float maxError)
+{
+  Triangulator triangulator(tex);
+  triangulator.ComputeErrors();
+  triangulator.Emit(maxError);
+
+  auto& vertices = triangulator.vertices;
+  auto& indices = triangulator.indices;
+
+  mesh->Free();
+  mesh->NumVertices = int(vertices.size() / 3);
+  mesh->NumTriangles = int(indices.size() / 3);
+  mesh->Vertices = new float[vertices.size()];
+  mesh->Indices = new int[indices.size()];
+  copy(vertices.begin(), vertices.end(), mesh->Vertices);
+  copy(indices.begin(), indices.end(), mesh->Indices);
+}
@@ -0,0 +1,40 @@
+/**
+ * @file heightmesh.h
+ * @brief Simplified meshes from heightmaps
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include "gentexture.h"
+
+struct HeightMesh
+{
+  float* Vertices;    // x, y, z for each vertex
+  int NumVertices;
+  int* Indices;       // 3 vertices for each triangle
+  int NumTriangles;
+
+  HeightMesh();
+  HeightMesh(const HeightMesh &) = delete;
+  ~HeightMesh();
+  void Free();
+};
+
+// Builds a mesh of the heightmap given by the red channel of 'tex'.
+// x and y go from 0 to 1 across the texture, z from 0 (red = 0) to 1
+// (red = 65535). The texture wraps: the last row and column of vertices
+// have the heights of the first ones.
+// The mesh is simplified as long as no height of the heightmap is further
+// than 'maxError' (in z units) from the mesh, so flat areas get large
+// triangles. There are no cracks (T-junctions) in the mesh.
+void HeightmapMesh(HeightMesh* mesh, const Texture& tex, float maxError);
@@ -0,0 +1,110 @@
+/**
+ * @file ktg.h
+ * @brief Texture operators
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include "gentexture.h"
+
+// Version of the results of the operators. Bump it whenever an operator
+// gives different pixels: results cached on disk (see texture_cache.d in
+// lib_ops) are keyed by it.
+static const int AlgorithmVersion = 1;
+
+///////////////////////////////////////////////////////////////////////////////
+// Generators
+///////////////////////////////////////////////////////////////////////////////
+void Noise(Texture* dest, const Texture& grad, int freqX, int freqY, int oct, float fadeoff, int seed, NoiseMode mode);
+void Noise(Texture* dest, const CompiledGradient& grad, int freqX, int freqY, int oct, float fadeoff, int seed,
+           NoiseMode mode);
+void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, float orgx, float orgy, float ux, float uy,
+              float vx, float vy, float rectu, float rectv, Rect* changed = nullptr);
+void GlowRect(Texture* dest, const Texture& bgTex, const CompiledGradient& grad, float orgx, float orgy, float ux,
+              float uy, float vx, float vy, float rectu, float rectv, Rect* changed = nullptr);
+void Cells(Texture* dest, const Texture& grad, const CellCenter* centers, int nCenters, float amp, CellMode mode);
+void Cells(Texture* dest, const CompiledGradient& grad, const CellCenter* centers, int nCenters, float amp,
+           CellMode mode);
+void Voronoi(Texture* dest, float intensity, int maxCount, float minDist, int seed = 0);
+int PoissonDisk(CellCenter* centers, int maxCount, float minDist, int seed);
+
+// Squared Euclidean distance (in pixels) from each pixel to the nearest
+// pixel of 'shape' whose channel (0: r, 1: g, 2: b, 3: a) reaches
+// 'threshold'; 1e20 if there's none. Distances wrap around the texture,
+// except in the clamped directions (see FilterMode).
+// Linear time, whatever the distances (Felzenszwalb-Huttenlocher).
+void DistanceTransform(float* dist2, const Texture& shape, int channel, float threshold, int wrapMode);
+
+// Composites 'grad' over 'bgTex' around the shapes of 'shape', as GlowRect
+// does around its rectangle: the gradient goes from the shapes (0) to
+// 'radius' away (1), relative to the width of the texture.
+void DistanceGlow(Texture* dest, const Texture& bgTex, const Texture& shape, const Texture& grad, int channel,
+                  float threshold, float radius, int wrapMode);
+void DistanceGlow(Texture* dest, const Texture& bgTex, const Texture& shape, const CompiledGradient& grad, int channel,
+                  float threshold, float radius, int wrapMode);
+
+///////////////////////////////////////////////////////////////////////////////
+// Combiners
+///////////////////////////////////////////////////////////////////////////////
+void Ternary(Texture* dest, const Texture& in1Tex, const Texture& in2Tex, const Texture& in3Tex, TernaryOp op);
+void Paste(Texture* dest, const Texture& bgTex, const Texture& inTex, float orgx, float orgy, float ux, float uy,
+           float vx, float vy, CombineOp op, int mode, Rect* changed = nullptr);
+void Bump(Texture* dest, const Texture& surface, const Texture& normals, const Texture* specular,
+          const Texture* falloffMap, float px, float py, float pz, float dx, float dy, float dz, Pixel ambient,
+          Pixel diffuse, bool directional, const Rect* region = nullptr);
+void Bump(Texture* dest, const Texture& surface, const Texture& normals, const CompiledGradient* specular,
+          const CompiledGradient* falloffMap, float px, float py, float pz, float dx, float dy, float dz,
+          Pixel ambient, Pixel diffuse, bool directional, const Rect* region = nullptr);
+void LinearCombine(Texture* dest, Pixel color, float constWeight, const LinearInput* inputs, int nInputs);
+
+///////////////////////////////////////////////////////////////////////////////
+// Filters
+///////////////////////////////////////////////////////////////////////////////
+void ColorMatrixTransform(Texture* dest, const Texture& x, Matrix44& matrix, bool clampPremult);
+void CoordMatrixTransform(Texture* dest, const Texture& in, Matrix44& matrix, int mode);
+void Rotozoom(Texture* dest, const Texture& in, float angle, float zoom, int mode);
+void ColorRemap(Texture* dest, const Texture& inTex, const Texture& mapR, const Texture& mapG, const Texture& mapB,
+                const Rect* region = nullptr);
+void ColorRemap(Texture* dest, const Texture& inTex, const CompiledGradient& mapR, const CompiledGradient& mapG,
+                const CompiledGradient& mapB, const Rect* region = nullptr);
+void CoordRemap(Texture* dest, const Texture& in, const Texture& remapTex, float strengthU, float strengthV, int mode);
+void Derive(Texture* dest, const Texture& in, DeriveOp op, float strength, const Rect* region = nullptr);
+void Blur(Texture* dest, const Texture& inImg, float sizex, float sizey, int order, int wrapMode,
+          const Rect* region = nullptr);
+
+// Pixels of the blurred texture depending on the pixels in 'r'
+Rect BlurFootprint(const Texture& tex, Rect r, float sizex, float sizey, int order, int wrapMode);
+
+// Minimum or maximum over a window of size (sizex, sizey), per channel.
+// Sizes and wrap modes are as in Blur; the cost doesn't depend on the sizes.
+void Morphology(Texture* dest, const Texture& in, float sizex, float sizey, MorphOp op, int wrapMode,
+                const Rect* region = nullptr);
+
+// Pixels of the transformed texture depending on the pixels in 'r'
+Rect MorphologyFootprint(const Texture& tex, Rect r, float sizex, float sizey, MorphOp op, int wrapMode);
+
+// Weighted sum of the kw x kh pixels around each pixel, the kernel being
+// given row by row, centered on (kw/2, kh/2). Coordinates are wrapped or
+// clamped as in Blur.
+// Separable kernels run as two 1D passes, large ones through an FFT.
+// The paths round differently, so their results may differ by one unit
+// from the exact sum (the path only depends on the kernel, though).
+// A region gives exactly the pixels of the whole texture.
+void Convolve(Texture* dest, const Texture& in, const float* kernel, int kw, int kh, int wrapMode,
+              const Rect* region = nullptr);
+void ConvolvePreset(Texture* dest, const Texture& in, KernelPreset preset, float p0, float p1, int wrapMode,
+                    const Rect* region = nullptr);
+
+// Pixels of the convolved texture depending on the pixels in 'r'
+Rect ConvolveFootprint(const Texture& tex, Rect r, int kw, int kh, int wrapMode);
+Rect ConvolvePresetFootprint(const Texture& tex, Rect r, KernelPreset preset, float p0, float p1, int wrapMode);
@@ -0,0 +1,305 @@
+/**
+ * @file parallel.cpp
+ * @brief Data-parallel loops
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "parallel.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+using namespace std;
+
+namespace
+{
+atomic<bool> g_Cancelled(false);
+}
+
+void SetCancelled(bool cancelled)
+{
+  g_Cancelled.store(cancelled, memory_order_relaxed);
+}
+
+bool IsCancelled()
+{
+  return g_Cancelled.load(memory_order_relaxed);
+}
+
+namespace
+{
+// Chunks of one loop, claimed one at a time by the pool and the caller
+struct ChunkJob
+{
+  const function<void(int)>* runChunk;
+  int numChunks;
+  atomic<int> next { 0 };
+
+  // guarded by the lock of the pool
+  int done = 0;
+  int users = 0; // pool threads working on the job
+  condition_variable finished;
+
+  // Runs chunks until none is left, returns their count
+  int Claim()
+  {
+    int count = 0;
+
+    for(int chunk; (chunk = next++) < numChunks; ++count)
+      (*runChunk)(chunk);
+
+    return count;
+  }
+};
+
+class ThreadPool
+{
+public:
+  ThreadPool()
+  {
+    const int numWorkers = max(0, int(thread::hardware_concurrency()) - 1);
+
+    for(int i = 0; i < numWorkers; ++i)
+      workers.push_back(thread(&ThreadPool::Work, this));
+  }
+
+  ~ThreadPool()
+  {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+
+    wakeUp.notify_all();
+
+    for(auto& t : workers)
+      t.join();
+  }
+
+  void Run(int numChunks, const function<void(int)>& runChunk)
+  {
+    if(workers.empty())
+    {
+      for(int chunk = 0; chunk < numChunks; ++chunk)
+        runChunk(chunk);
+
+      return;
+    }
+
+    ChunkJob job;
+    job.runChunk = &runChunk;
+    job.numChunks = numChunks;
+
+    {
+      lock_guard<mutex> guard(lock);
+      jobs.push_back(&job);
+    }
+
+    for(int i = 1; i < numChunks; ++i)
+      wakeUp.notify_one();
+
+    const int count = job.Claim();
+
+    unique_lock<mutex> guard(lock);
+    jobs.erase(remove(jobs.begin(), jobs.end(), &job), jobs.end());
+    job.done += count;
+    job.finished.wait(guard, [&] () { return job.done == job.numChunks && job.users == 0; });
+  }
+
+private:
+  void Work()
+  {
+    unique_lock<mutex> guard(lock);
+
+    while(true)
+    {
+      wakeUp.wait(guard, [&] () { return stopping || !jobs.empty(); });
+
+      if(stopping)
+        return;
+
+      auto job = jobs.front();
+
+      // all its chunks are taken: the threads running them will finish it
+      if(job->next >= job->numChunks)
+      {
+        jobs.pop_front();
+        continue;
+      }
+
+      ++job->users;
+      guard.unlock();
+
+      const int count = job->Claim();
+
+      guard.lock();
+      job->done += count;
+      --job->users;
+
+      if(job->done == job->numChunks && job->users == 0)
+        job->finished.notify_all();
+    }
+  }
+
+  mutex lock;
+  condition_variable wakeUp;
+  deque<ChunkJob*> jobs;
+  bool stopping = false;
+  vector<thread> workers;
+};
+}
+
+void RunChunks(int numChunks, const function<void(int)>& runChunk)
+{
+  static ThreadPool pool;
+  pool.Run(numChunks, runChunk);
+}
+
+namespace
+{
+// Tasks ready to run. The owner works at the back, thieves at the front.
+struct WorkQueue
+{
+  mutex lock;
+  deque<int> tasks;
+
+  void Push(int task)
+  {
+    lock_guard<mutex> guard(lock);
+    tasks.push_back(task);
+  }
+
+  bool Pop(int& task)
+  {
+    lock_guard<mutex> guard(lock);
+
+    if(tasks.empty())
+      return false;
+
+    task = tasks.back();
+    tasks.pop_back();
+    return true;
+  }
+
+  bool Steal(int& task)
+  {
+    lock_guard<mutex> guard(lock);
+
+    if(tasks.empty())
+      return false;
+
+    task = tasks.front();
+    tasks.pop_front();
+    return true;
+  }
+};
+}
+
+void RunTaskGraph(const vector<vector<int>>& deps, int numThreads, const function<void(int)>& func)
+{
+  const int numTasks = int(deps.size());
+
+  if(numTasks == 0)
+    return;
+
+  numThreads = max(1, min(numThreads, numTasks));
+
+  vector<vector<int>> successors(numTasks);
+  unique_ptr<atomic<int>[]> pending(new atomic<int>[numTasks]);
+
+  for(int task = 0; task < numTasks; ++task)
+  {
+    pending[task] = int(deps[task].size());
+
+    for(auto dep : deps[task])
+      successors[dep].push_back(task);
+  }
+
+  vector<WorkQueue> queues(numThreads);
+  atomic<int> remaining(numTasks);
+  atomic<int> ready(0); // tasks in the queues
+
+  // initial tasks: in reverse order, so each thread starts with the first ones
+  for(int task = numTasks - 1, i = 0; task >= 0; --task)
+  {
+    if(deps[task].empty())
+    {
+      queues[i++ % numThreads].Push(task);
+      ++ready;
+    }
+  }
+
+  // idle threads sleep until a task becomes ready, or the graph completes
+  mutex idleLock;
+  condition_variable wakeUp;
+
+  auto signal = [&] (bool all)
+                {
+                  // taking the lock orders the signal after the check of a
+                  // thread about to sleep
+                  {
+                    lock_guard<mutex> guard(idleLock);
+                  }
+
+                  if(all)
+                    wakeUp.notify_all();
+                  else
+                    wakeUp.notify_one();
+                };
+
+  auto worker = [&] (int self)
+                {
+                  while(remaining > 0)
+                  {
+                    int task;
+                    bool found = queues[self].Pop(task);
+
+                    for(int i = 1; !found && i < numThreads; ++i)
+                      found = queues[(self + i) % numThreads].Steal(task);
+
+                    if(!found)
+                    {
+                      unique_lock<mutex> guard(idleLock);
+                      wakeUp.wait(guard, [&] () { return ready > 0 || remaining == 0; });
+                      continue;
+                    }
+
+                    --ready;
+                    func(task);
+
+                    for(auto next : successors[task])
+                    {
+                      if(--pending[next] == 0)
+                      {
+                        queues[self].Push(next);
+                        ++ready;
+                        signal(false);
+                      }
+                    }
+
+                    if(--remaining == 0)
+                      signal(true);
+                  }
+                };
+
+  vector<thread> threads;
+
+  for(int i = 1; i < numThreads; ++i)
+    threads.push_back(thread(worker, i));
+
+  worker(0);
+
+  for(auto& t : threads)
+    t.join();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file parallel.h
+ * @brief Data-parallel loops
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include "tuning.h"
+
+// Calls runChunk(chunk) for each chunk in [0;numChunks[, on the threads of a
+// pool shared by all the loops (one per hardware thread, started on first
+// use) and on the calling thread, which works on its own chunks too: loops
+// can be nested, or run from several threads at once.
+void RunChunks(int numChunks, const std::function<void(int)>& runChunk);
+
+// Calls func(first, last) for contiguous chunks covering [begin;end[,
+// one chunk per thread (see TuningProfile::threads).
+// Chunks smaller than 'grain' iterations aren't worth a thread.
+template<typename Func>
+void ParallelForChunks(int begin, int end, int grain, Func func)
+{
+  const int count = end - begin;
+  const int maxThreads = Tuning().threads > 0 ? Tuning().threads : int(std::thread::hardware_concurrency());
+  const int numChunks = std::max(1, std::min(maxThreads, count / std::max(1, grain)));
+
+  auto runChunk = [&] (int chunk)
+                  {
+                    const int first = begin + int(int64_t(count) * chunk / numChunks);
+                    const int last = begin + int(int64_t(count) * (chunk + 1) / numChunks);
+                    func(first, last);
+                  };
+
+  if(numChunks == 1)
+    runChunk(0);
+  else
+    RunChunks(numChunks, runChunk);
+}
+
+// Calls func(i) for each i in [begin;end[, split as above.
+template<typename Func>
+void ParallelFor(int begin, int end, int grain, Func func)
+{
+  ParallelForChunks(begin, end, grain, [&] (int first, int last)
+                    {
+                      for(int i = first; i < last; ++i)
+                        func(i);
+                    });
+}
+
+// Cooperative cancellation of the kernels, e.g when an interactive
+// evaluation becomes stale. Once set, long kernels (Noise, Cells, Blur)
+// return after their current rows, leaving their output incomplete.
+void SetCancelled(bool cancelled);
+bool IsCancelled();
+
+// Runs func(task) for each task of a dependency graph, on 'numThreads'
+// threads (the calling thread included). A task only starts after all the
+// tasks listed in deps[task] have finished.
+// Each thread runs the tasks it made ready first, and steals from the other
+// threads when it has none left, or sleeps until a task becomes ready.
+// 'func' must not throw.
+void RunTaskGraph(const std::vector<std::vector<int>>& deps, int numThreads, const std::function<void(int)>& func);
@@ -0,0 +1,749 @@
+/**
+ * @file runtime.cpp
+ * @brief Native execution of serialized edit lists
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "runtime.h"
+#include "ktg.h"
+#include "helpers.h"
+#include "parallel.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Loading                                                            ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+namespace
+{
+struct Reader
+{
+  const uint8_t* pos;
+  const uint8_t* end;
+
+  void Read(void* dst, size_t n)
+  {
+    if(size_t(end - pos) < n)
+      throw runtime_error("truncated document");
+
+    memcpy(dst, pos, n);
+    pos += n;
+  }
+
+  uint8_t U8()
+  {
+    uint8_t val;
+    Read(&val, 1);
+    return val;
+  }
+
+  uint32_t U32()
+  {
+    uint8_t b[4];
+    Read(b, 4);
+    return b[0] | (b[1] << 8) | (b[2] << 16) | (uint32_t(b[3]) << 24);
+  }
+
+  float F32()
+  {
+    uint32_t bits = U32();
+    float val;
+    memcpy(&val, &bits, sizeof val);
+    return val;
+  }
+
+  // Number of items of at least 'minSize' bytes each: checked against the
+  // remaining bytes before anything gets allocated for the items.
+  size_t Count(uint32_t count, size_t minSize)
+  {
+    if(count > size_t(end - pos) / minSize)
+      throw runtime_error("truncated document");
+
+    return count;
+  }
+
+  string String()
+  {
+    string s(U8(), '\0');
+    Read(&s[0], s.size());
+    return s;
+  }
+};
+}
+
+void LoadDocument(Document& doc, const void* data, size_t size)
+{
+  Reader r { (const uint8_t*)data, (const uint8_t*)data + size };
+
+  char magic[4];
+  r.Read(magic, 4);
+
+  if(memcmp(magic, "KTGB", 4))
+    throw runtime_error("not a serialized edit list");
+
+  if(r.U32() != DocumentVersion)
+    throw runtime_error("unsupported document version");
+
+  // an operation takes at least 2 bytes: its name length and its number of arguments
+  doc.ops.resize(r.Count(r.U32(), 2));
+
+  for(auto& op : doc.ops)
+  {
+    op.name = r.String();
+    // an argument takes at least its type byte
+    op.args.resize(r.Count(r.U8(), 1));
+
+    for(auto& arg : op.args)
+    {
+      arg.type = ArgType(r.U8());
+
+      switch(arg.type)
+      {
+      case ArgNull:
+        break;
+      case ArgReal:
+      case ArgVec2:
+      case ArgVec3:
+
+        for(int i = 0; i < arg.type; i++)
+          arg.v[i] = r.F32();
+
+        break;
+      case ArgIdentifier:
+        arg.name = r.String();
+        break;
+      default:
+        throw runtime_error("invalid argument type");
+      }
+    }
+  }
+}
+
+void LoadDocumentFile(Document& doc, const char* path)
+{
+  FILE* fp = fopen(path, "rb");
+
+  if(!fp)
+    throw runtime_error("can't open '" + string(path) + "'");
+
+  vector<uint8_t> data;
+  uint8_t buffer[4096];
+  size_t n;
+
+  while((n = fread(buffer, 1, sizeof buffer, fp)) > 0)
+    data.insert(data.end(), buffer, buffer + n);
+
+  fclose(fp);
+
+  LoadDocument(doc, data.data(), data.size());
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Execution                                                          ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+// These operations mirror the ones of lib_ops/ops_texture.d,
+// down to their argument conversions.
+namespace
+{
+struct Vec3
+{
+  float x, y, z;
+};
+
+// Textures are shared between the current one, the stored ones and the
+// displayed one: a shared texture is copied only before being modified.
+typedef shared_ptr<Texture> TexturePtr;
+
+// White to black gradient, shared by all generators
+const CompiledGradient& WhiteToBlack()
+{
+  static const Texture colors = []()
+                                {
+                                  Texture grad(2, 1);
+                                  grad.Data[0].Init(0xffffffff);
+                                  grad.Data[1].Init(0x00000000);
+                                  return grad;
+                                } ();
+
+  static const CompiledGradient gradient(colors);
+
+  return gradient;
+}
+
+struct RenderState
+{
+  const Texture& Current()
+  {
+    if(!current)
+      throw runtime_error("please create a texture first");
+
+    return *current;
+  }
+
+  // Current texture, before modifying it in place.
+  // Without 'keepPixels', the caller overwrites all the pixels.
+  Texture& Writable(bool keepPixels)
+  {
+    auto& cur = Current();
+
+    if(current.use_count() > 1)
+      current = keepPixels ? make_shared<Texture>(cur) : make_shared<Texture>(cur.XRes, cur.YRes);
+
+    return *current;
+  }
+
+  // Makes 'tex' the current texture
+  void SetCurrent(Texture& tex)
+  {
+    current = make_shared<Texture>();
+    current->Swap(tex);
+  }
+
+  const Texture& Stored(int idx)
+  {
+    auto& tex = slots[clamp(idx, 0, 15)];
+
+    if(!tex)
+      throw runtime_error("No texture at this index");
+
+    return *tex;
+  }
+
+  TexturePtr current;
+  TexturePtr slots[16];
+  TexturePtr displayed;
+  int seed = 0;
+};
+
+const char* TypeName(ArgType type)
+{
+  static const char* names[] = { "Null", "Real", "Vec2", "Vec3", "Identifier" };
+  return names[type];
+}
+
+const Argument& Arg(const Operation& op, int i, ArgType type)
+{
+  auto& arg = op.args[i];
+
+  if(arg.type != type)
+    throw runtime_error(string("Expected a ") + TypeName(type) + ", got a " + TypeName(arg.type));
+
+  return arg;
+}
+
+float Real(const Operation& op, int i)
+{
+  return Arg(op, i, ArgReal).v[0];
+}
+
+int Int(const Operation& op, int i)
+{
+  return lrint(Real(op, i));
+}
+
+Vec3 AsVec3(const Operation& op, int i)
+{
+  auto& arg = Arg(op, i, ArgVec3);
+  return Vec3 { arg.v[0], arg.v[1], arg.v[2] };
+}
+
+// Same conversions as D's 'cast(ushort)' on a float
+uint16_t ToU16(float val)
+{
+  return uint16_t(int(val));
+}
+
+Pixel ToPixel(Vec3 v)
+{
+  auto rescale = [] (float val)
+                 {
+                   return uint8_t(clamp(val * 256, 0.0f, 255.0f));
+                 };
+
+  Pixel result;
+  result.Init(rescale(v.x), rescale(v.y), rescale(v.z), 255);
+  return result;
+}
+
+void CheckSameSize(const Texture& a, const Texture& b)
+{
+  if(a.NPixels != b.NPixels)
+    throw runtime_error("Texture must have the same size");
+}
+
+void op_picture(RenderState&, const Operation&)
+{
+  // picture dashboard creation: nothing to do here
+}
+
+void op_texture(RenderState& s, const Operation& op)
+{
+  auto& size = Arg(op, 0, ArgVec2);
+
+  Texture tex(int(max(size.v[0], 16.0f)), int(max(size.v[1], 16.0f)));
+
+  for(int i = 0; i < tex.NPixels; ++i)
+  {
+    tex.Data[i].r = 0;
+    tex.Data[i].g = 255;
+    tex.Data[i].b = 0;
+    tex.Data[i].a = 0;
+  }
+
+  s.SetCurrent(tex);
+}
+
+void op_display(RenderState& s, const Operation&)
+{
+  s.Current();
+  s.displayed = s.current;
+}
+
+void op_store(RenderState& s, const Operation& op)
+{
+  s.Current();
+  s.slots[clamp(Int(op, 0), 0, 15)] = s.current;
+}
+
+void op_load(RenderState& s, const Operation& op)
+{
+  s.Stored(Int(op, 0));
+  s.current = s.slots[clamp(Int(op, 0), 0, 15)];
+}
+
+void op_noise(RenderState& s, const Operation& op)
+{
+  Noise(&s.Writable(false), WhiteToBlack(), int(Real(op, 0)), int(Real(op, 1)), int(Real(op, 2)), Real(op, 3), 123 + s.seed,
+        NoiseMode(NoiseDirect | NoiseBandlimit | NoiseNormalize));
+}
+
+void op_derive(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+  auto deriveOp = DeriveOp(clamp(int(Real(op, 0)), 0, int(DeriveNormals)));
+
+  Texture dst(cur.XRes, cur.YRes);
+  Derive(&dst, cur, deriveOp, Real(op, 1));
+  s.SetCurrent(dst);
+}
+
+void op_voronoi(RenderState& s, const Operation& op)
+{
+  Voronoi(&s.Writable(false), Real(op, 0), Int(op, 1), Real(op, 2), s.seed);
+}
+
+void op_mix(RenderState& s, const Operation& op)
+{
+  auto& other = s.Stored(Int(op, 0));
+  auto alpha = clamp(Real(op, 1), 0.0f, 1.0f);
+
+  CheckSameSize(s.Current(), other);
+
+  // may copy the current texture, if it's 'other'
+  auto& cur = s.Writable(true);
+
+  auto blend = [=] (float a, float b)
+               {
+                 return ToU16(a * (1.0f - alpha) + b * alpha);
+               };
+
+  for(int i = 0; i < cur.NPixels; ++i)
+  {
+    auto& A = cur.Data[i];
+    auto& B = other.Data[i];
+
+    // red is blended with blue, as in ops_texture.d
+    A.r = blend(A.r, B.b);
+    A.g = blend(A.g, B.g);
+    A.b = blend(A.b, B.b);
+    A.a = blend(A.a, B.a);
+  }
+}
+
+void op_blur(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+
+  Texture dst(cur.XRes, cur.YRes);
+  Blur(&dst, cur, Real(op, 0), Real(op, 1), Int(op, 2), Int(op, 3));
+  s.SetCurrent(dst);
+}
+
+void op_convolve(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+  auto preset = KernelPreset(clamp(int(Real(op, 0)), 0, int(KernelMotion)));
+
+  Texture dst(cur.XRes, cur.YRes);
+  ConvolvePreset(&dst, cur, preset, Real(op, 1), Real(op, 2), Int(op, 3));
+  s.SetCurrent(dst);
+}
+
+void op_morph(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+  auto morphOp = MorphOp(clamp(int(Real(op, 0)), 0, int(MorphClose)));
+
+  Texture dst(cur.XRes, cur.YRes);
+  Morphology(&dst, cur, Real(op, 1), Real(op, 2), morphOp, Int(op, 3));
+  s.SetCurrent(dst);
+}
+
+void op_bump(RenderState& s, const Operation& op)
+{
+  // the current texture is overwritten, and may be one of the inputs
+  auto& cur = s.Writable(false);
+  auto& baseTex = s.Stored(Int(op, 0));
+  CheckSameSize(cur, baseTex);
+
+  auto& bumpMap = s.Stored(Int(op, 1));
+  CheckSameSize(cur, bumpMap);
+
+  auto p = AsVec3(op, 2);
+  auto d = AsVec3(op, 3);
+  auto ambient = ToPixel(AsVec3(op, 4));
+  auto diffuse = ToPixel(AsVec3(op, 5));
+
+  Bump(&cur, baseTex, bumpMap, (const CompiledGradient*)nullptr, nullptr, p.x, p.y, p.z, d.x, d.y, d.z, ambient,
+       diffuse, true);
+}
+
+void op_rect(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+
+  Texture dst(cur.XRes, cur.YRes);
+  GlowRect(&dst, cur, WhiteToBlack(), Real(op, 0), Real(op, 1), Real(op, 2), Real(op, 3), Real(op, 4), Real(op, 5),
+           Real(op, 6), Real(op, 7));
+  s.SetCurrent(dst);
+}
+
+void op_glow(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+  auto& shape = s.Stored(Int(op, 0));
+  CheckSameSize(cur, shape);
+
+  Texture dst(cur.XRes, cur.YRes);
+  DistanceGlow(&dst, cur, shape, WhiteToBlack(), Int(op, 1), Real(op, 2), Real(op, 3), Int(op, 4));
+  s.SetCurrent(dst);
+}
+
+void op_mul(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Writable(true);
+  auto f = Real(op, 0);
+
+  for(int i = 0; i < cur.NPixels; ++i)
+  {
+    auto& pel = cur.Data[i];
+    pel.r = ToU16(pel.r * f);
+    pel.g = ToU16(pel.g * f);
+    pel.b = ToU16(pel.b * f);
+    pel.a = ToU16(pel.a * f);
+  }
+}
+
+void op_offset(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Writable(true);
+  auto r = Real(op, 0);
+  auto g = Real(op, 1);
+  auto b = Real(op, 2);
+  auto a = Real(op, 3);
+
+  for(int i = 0; i < cur.NPixels; ++i)
+  {
+    auto& pel = cur.Data[i];
+    pel.r = ToU16(pel.r + r);
+    pel.g = ToU16(pel.g + g);
+    pel.b = ToU16(pel.b + b);
+    pel.a = ToU16(pel.a + a);
+  }
+}
+
+void op_rotozoom(RenderState& s, const Operation& op)
+{
+  auto& cur = s.Current();
+
+  Texture dst(cur.XRes, cur.YRes);
+  Rotozoom(&dst, cur, Real(op, 0), Real(op, 1), WrapU | WrapV | FilterBilinear);
+  s.SetCurrent(dst);
+}
+
+struct OperatorDef
+{
+  void (* func)(RenderState& s, const Operation& op);
+  int numArgs; // -1: not checked
+};
+
+const unordered_map<string, OperatorDef> g_Operators =
+{
+  { "picture", { &op_picture, -1 } },
+  { "texture", { &op_texture, 1 } },
+  { "display", { &op_display, -1 } },
+  { "tstore", { &op_store, 1 } },
+  { "tload", { &op_load, 1 } },
+  { "tnoise", { &op_noise, 4 } },
+  { "tderive", { &op_derive, 2 } },
+  { "tvoronoi", { &op_voronoi, 3 } },
+  { "tmix", { &op_mix, 2 } },
+  { "tblur", { &op_blur, 4 } },
+  { "tconvolve", { &op_convolve, 4 } },
+  { "tmorph", { &op_morph, 4 } },
+  { "tbump", { &op_bump, 6 } },
+  { "trect", { &op_rect, 8 } },
+  { "tglow", { &op_glow, 5 } },
+  { "tmul", { &op_mul, 1 } },
+  { "toffset", { &op_offset, 4 } },
+  { "trotozoom", { &op_rotozoom, 2 } },
+};
+
+void RunOperation(RenderState& state, const Operation& op)
+{
+  auto i = g_Operators.find(op.name);
+
+  if(i == g_Operators.end())
+    throw runtime_error("unsupported operation: '" + op.name + "'");
+
+  auto& def = i->second;
+
+  if(def.numArgs >= 0 && def.numArgs != int(op.args.size()))
+  {
+    char msg[256];
+    snprintf(msg, sizeof msg, "invalid number of arguments for '%s' (%d instead of %d)", op.name.c_str(),
+             int(op.args.size()), def.numArgs);
+    throw runtime_error(msg);
+  }
+
+  def.func(state, op);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Scheduling                                                         ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+// The edit list is cut into segments, each starting where the current
+// texture gets replaced ('texture' or 'tload'). Segments only communicate
+// through the stored textures: a segment depends on the segments that
+// stored the textures it reads, and each one runs on its own RenderState.
+// Stored textures are never modified in place, so a segment can pick them
+// from the final state of the segment that stored them.
+
+int SlotArg(const Operation& op, int i)
+{
+  if(i >= int(op.args.size()) || op.args[i].type != ArgReal)
+    return -1; // the operation will fail anyway
+
+  return clamp(int(lrint(op.args[i].v[0])), 0, 15);
+}
+
+// Stored textures read by an operation
+vector<int> SlotReads(const Operation& op)
+{
+  vector<int> slots;
+
+  if(op.name == "tload" || op.name == "tmix" || op.name == "tglow")
+    slots.push_back(SlotArg(op, 0));
+  else if(op.name == "tbump")
+    slots = { SlotArg(op, 0), SlotArg(op, 1) };
+
+  return slots;
+}
+
+bool StartsSegment(const Operation& op)
+{
+  return op.name == "texture" || op.name == "tload";
+}
+
+struct Segment
+{
+  int begin, end; // operations
+  vector<int> deps;
+  int inputs[16]; // segment which stored each texture read, or -1
+  bool displays = false;
+
+  // execution
+  RenderState state;
+  bool failed = false;
+  int errorOp = -1; // failed operation, if any
+  string error;
+};
+
+vector<Segment> CutSegments(const Document& doc)
+{
+  vector<Segment> segments;
+  int lastWriter[16];
+  fill(begin(lastWriter), end(lastWriter), -1);
+
+  for(int i = 0; i < int(doc.ops.size()); ++i)
+  {
+    if(segments.empty() || StartsSegment(doc.ops[i]))
+    {
+      segments.push_back(Segment());
+      segments.back().begin = i;
+      fill(begin(segments.back().inputs), end(segments.back().inputs), -1);
+    }
+
+    segments.back().end = i + 1;
+  }
+
+  for(int k = 0; k < int(segments.size()); ++k)
+  {
+    auto& seg = segments[k];
+    bool written[16] {};
+
+    for(int i = seg.begin; i < seg.end; ++i)
+    {
+      auto& op = doc.ops[i];
+
+      for(auto slot : SlotReads(op))
+      {
+        if(slot < 0 || written[slot] || lastWriter[slot] < 0 || seg.inputs[slot] >= 0)
+          continue;
+
+        seg.inputs[slot] = lastWriter[slot];
+
+        if(find(seg.deps.begin(), seg.deps.end(), lastWriter[slot]) == seg.deps.end())
+          seg.deps.push_back(lastWriter[slot]);
+      }
+
+      if(op.name == "tstore" && SlotArg(op, 0) >= 0)
+        written[SlotArg(op, 0)] = true;
+
+      if(op.name == "display")
+        seg.displays = true;
+    }
+
+    for(int slot = 0; slot < 16; ++slot)
+    {
+      if(written[slot])
+        lastWriter[slot] = k;
+    }
+  }
+
+  return segments;
+}
+
+void RunSegment(const Document& doc, vector<Segment>& segments, int k)
+{
+  auto& seg = segments[k];
+
+  for(int slot = 0; slot < 16; ++slot)
+  {
+    if(seg.inputs[slot] < 0)
+      continue;
+
+    auto& producer = segments[seg.inputs[slot]];
+
+    if(producer.failed)
+    {
+      seg.failed = true;
+      return;
+    }
+
+    seg.state.slots[slot] = producer.state.slots[slot];
+  }
+
+  for(int i = seg.begin; i < seg.end; ++i)
+  {
+    try
+    {
+      RunOperation(seg.state, doc.ops[i]);
+    }
+    catch(exception& e)
+    {
+      seg.failed = true;
+      seg.errorOp = i;
+      seg.error = e.what();
+      return;
+    }
+  }
+}
+}
+
+void RenderDocument(const Document& doc, Texture& result, int numThreads)
+{
+  RenderDocument(doc, Variant(), result, numThreads);
+}
+
+void RenderDocument(const Document& doc, const Variant& variant, Texture& result, int numThreads)
+{
+  if(!variant.overrides.empty())
+  {
+    Document copy = doc;
+
+    for(auto& o : variant.overrides)
+    {
+      if(o.op < 0 || o.op >= int(copy.ops.size()) || o.arg < 0 || o.arg >= int(copy.ops[o.op].args.size()))
+        throw runtime_error("invalid argument override");
+
+      auto& arg = copy.ops[o.op].args[o.arg];
+      arg.type = ArgReal;
+      arg.v[0] = o.value;
+    }
+
+    Variant rest;
+    rest.seed = variant.seed;
+    RenderDocument(copy, rest, result, numThreads);
+    return;
+  }
+
+  auto segments = CutSegments(doc);
+
+  for(auto& seg : segments)
+    seg.state.seed = variant.seed;
+
+  vector<vector<int>> deps;
+
+  for(auto& seg : segments)
+    deps.push_back(seg.deps);
+
+  RunTaskGraph(deps, numThreads, [&] (int k) { RunSegment(doc, segments, k); });
+
+  // report the error a sequential execution would have stopped at
+  const Segment* firstError = nullptr;
+
+  for(auto& seg : segments)
+  {
+    if(seg.errorOp >= 0 && (!firstError || seg.errorOp < firstError->errorOp))
+      firstError = &seg;
+  }
+
+  if(firstError)
+    throw runtime_error(firstError->error);
+
+  for(auto seg = segments.rbegin(); seg != segments.rend(); ++seg)
+  {
+    if(seg->displays)
+    {
+      result = *seg->state.displayed;
+      return;
+    }
+  }
+
+  if(segments.empty())
+    throw runtime_error("please create a texture first");
+
+  result = segments.back().state.Current();
+}
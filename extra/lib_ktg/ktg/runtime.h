@@ -0,0 +1,86 @@
+/**
+ * @file runtime.h
+ * @brief Native execution of serialized edit lists
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "gentexture.h"
+
+// Serialized edit list, as written by 'architect --binary'.
+// All values are little-endian:
+//   "KTGB", u32 version, u32 number of operations, then for each operation:
+//   u8 name length, name, u8 number of arguments, then for each argument:
+//   u8 type (ArgType), followed by 0/1/2/3 float32, or u8 length + name.
+static const int DocumentVersion = 1;
+
+enum ArgType
+{
+  ArgNull = 0,
+  ArgReal,
+  ArgVec2,
+  ArgVec3,
+  ArgIdentifier,
+};
+
+struct Argument
+{
+  ArgType type;
+  float v[3];
+  std::string name; // ArgIdentifier only
+};
+
+struct Operation
+{
+  std::string name;
+  std::vector<Argument> args;
+};
+
+struct Document
+{
+  std::vector<Operation> ops;
+};
+
+// Parses a serialized edit list. Throws std::runtime_error on malformed input.
+void LoadDocument(Document& doc, const void* data, size_t size);
+void LoadDocumentFile(Document& doc, const char* path);
+
+// Variant of a document, e.g a tile of an atlas (see atlas.h)
+struct ArgOverride
+{
+  int op;       // operation index
+  int arg;      // argument index
+  float value;  // replaces the argument, as a Real
+};
+
+struct Variant
+{
+  int seed = 0; // added to the seeds of 'tnoise' and 'tvoronoi'
+  std::vector<ArgOverride> overrides;
+};
+
+// Executes the texture operations of 'doc', the same way architect does.
+// 'result' receives the displayed texture (or the current one if nothing
+// was displayed).
+// Independent branches of the edit list (communicating only through stored
+// textures) run concurrently on up to 'numThreads' threads; the result is
+// the same as a sequential execution.
+// Each call has its own state: documents can be rendered concurrently.
+// Throws std::runtime_error on unsupported operations or invalid arguments.
+void RenderDocument(const Document& doc, Texture& result, int numThreads = 1);
+
+// Same, for a variant of 'doc'. Throws std::runtime_error on invalid overrides.
+void RenderDocument(const Document& doc, const Variant& variant, Texture& result, int numThreads = 1);
@@ -0,0 +1,238 @@
+/**
+ * @file tuning.cpp
+ * @brief Per-machine settings of the kernels
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "tuning.h"
+#include "ktg.h"
+#include "helpers.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+struct Setting
+{
+  const char* name;
+  int TuningProfile::* field;
+  int min, max;
+};
+
+const Setting Settings[] =
+{
+  { "threads", &TuningProfile::threads, 0, 1024 },
+  { "blurColumns", &TuningProfile::blurColumns, 1, 256 },
+  { "blurRows", &TuningProfile::blurRows, 1, 1 << 16 },
+  { "cellsRows", &TuningProfile::cellsRows, 1, 1 << 16 },
+  { "convolveRows", &TuningProfile::convolveRows, 1, 1 << 16 },
+  { "glowRows", &TuningProfile::glowRows, 1, 1 << 16 },
+};
+
+TuningProfile& Current()
+{
+  static TuningProfile profile = [] ()
+                                 {
+                                   TuningProfile p;
+                                   LoadTuningProfile(p, TuningProfilePath().c_str());
+                                   return p;
+                                 } ();
+
+  return profile;
+}
+}
+
+const TuningProfile& Tuning()
+{
+  return Current();
+}
+
+void SetTuning(const TuningProfile& profile)
+{
+  Current() = profile;
+}
+
+string TuningProfilePath()
+{
+  if(auto path = getenv("KTG_PROFILE"))
+    return path;
+
+  auto home = getenv("HOME");
+  return string(home ? home : ".") + "/.ktg-profile";
+}
+
+bool LoadTuningProfile(TuningProfile& profile, const char* path)
+{
+  FILE* fp = fopen(path, "r");
+
+  if(!fp)
+    return false;
+
+  char line[256];
+
+  while(fgets(line, sizeof line, fp))
+  {
+    char name[64];
+    int value;
+
+    if(line[0] == '#' || sscanf(line, "%63s %d", name, &value) != 2)
+      continue;
+
+    for(auto& s : Settings)
+    {
+      if(!strcmp(s.name, name) && value >= s.min && value <= s.max)
+        profile.*s.field = value;
+    }
+  }
+
+  fclose(fp);
+  return true;
+}
+
+bool SaveTuningProfile(const TuningProfile& profile, const char* path)
+{
+  FILE* fp = fopen(path, "w");
+
+  if(!fp)
+    return false;
+
+  fprintf(fp, "# ktg tuning profile, see 'ktgrender -t'\n");
+
+  for(auto& s : Settings)
+    fprintf(fp, "%s %d\n", s.name, profile.*s.field);
+
+  return fclose(fp) == 0;
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Benchmarks                                                         ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+namespace
+{
+// Best time of a few runs, in milliseconds
+template<typename Func>
+double Measure(Func func)
+{
+  double best = 1e30;
+
+  for(int i = 0; i < 3; ++i)
+  {
+    auto t0 = chrono::steady_clock::now();
+    func();
+    auto t1 = chrono::steady_clock::now();
+    best = min(best, chrono::duration<double, milli>(t1 - t0).count());
+  }
+
+  return best;
+}
+
+// Sets 'field' of 'profile' to the fastest of 'candidates' for 'bench'.
+// The first candidates are the cheapest ones: a later one must be clearly
+// faster to be chosen.
+template<typename Func>
+void Pick(TuningProfile& profile, const char* name, int TuningProfile::* field, const vector<int>& candidates,
+          Func bench, FILE* log)
+{
+  int best = candidates[0];
+  double bestTime = 0;
+
+  for(auto candidate : candidates)
+  {
+    profile.*field = candidate;
+    SetTuning(profile);
+
+    auto time = Measure(bench);
+
+    if(log)
+      fprintf(log, "%-12s %4d: %8.2f ms\n", name, candidate, time);
+
+    if(candidate == candidates[0] || time < bestTime * 0.95)
+    {
+      best = candidate;
+      bestTime = time;
+    }
+  }
+
+  profile.*field = best;
+}
+
+uint32_t Random(uint32_t& seed)
+{
+  seed = seed * 1664525 + 1013904223;
+  return seed;
+}
+}
+
+TuningProfile AutoTune(FILE* log)
+{
+  const auto saved = Tuning();
+
+  uint32_t seed = 0x12345678;
+
+  Texture src(1024, 1024), dst(1024, 1024);
+
+  for(int i = 0; i < src.NPixels; ++i)
+    src.Data[i].Init(Random(seed));
+
+  Texture grad(2, 1);
+  grad.Data[0].Init(0xffffffff);
+  grad.Data[1].Init(0x00000000);
+  const CompiledGradient gradient(grad);
+
+  vector<CellCenter> centers(256);
+
+  for(auto& c : centers)
+  {
+    c.x = (Random(seed) >> 8) / float(1 << 24);
+    c.y = (Random(seed) >> 8) / float(1 << 24);
+    c.color.Init(Random(seed));
+  }
+
+  auto blurH = [&] () { Blur(&dst, src, 0.02f, 0.0f, 2, 0); };
+  auto blurV = [&] () { Blur(&dst, src, 0.0f, 0.02f, 2, 0); };
+  auto cells = [&] () { Cells(&dst, gradient, centers.data(), int(centers.size()), 1.0f, CellInner); };
+
+  float kernel[5 * 5];
+
+  for(auto& w : kernel)
+    w = (Random(seed) >> 8) / float(25 << 24);
+
+  auto convolve = [&] () { Convolve(&dst, src, kernel, 5, 5, 0); };
+  auto glow = [&] () { DistanceGlow(&dst, src, src, gradient, 3, 0.5f, 0.1f, 0); };
+
+  TuningProfile profile;
+
+  vector<int> threads;
+  const int hardwareThreads = max(1, int(thread::hardware_concurrency()));
+
+  for(int n = 1; n < hardwareThreads; n *= 2)
+    threads.push_back(n);
+
+  threads.push_back(hardwareThreads);
+
+  Pick(profile, "threads", &TuningProfile::threads, threads, [&] () { blurH(); blurV(); cells(); }, log);
+  Pick(profile, "blurColumns", &TuningProfile::blurColumns, { 1, 2, 4, 8, 16, 32 }, blurV, log);
+  Pick(profile, "blurRows", &TuningProfile::blurRows, { 1, 4, 16, 64, 256 }, blurH, log);
+  Pick(profile, "cellsRows", &TuningProfile::cellsRows, { 8, 32, 128, 512 }, cells, log);
+  Pick(profile, "convolveRows", &TuningProfile::convolveRows, { 1, 4, 16, 64 }, convolve, log);
+  Pick(profile, "glowRows", &TuningProfile::glowRows, { 1, 4, 16, 64 }, glow, log);
+
+  SetTuning(saved);
+
+  return profile;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file tuning.h
+ * @brief Per-machine settings of the kernels
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// Variants chosen by the kernels. None of them changes the results.
+struct TuningProfile
+{
+  int threads = 0;        // chunks of the data-parallel loops, 0: one per hardware thread
+  int blurColumns = 8;    // columns blurred together by the vertical pass of Blur
+  int blurRows = 16;      // minimum rows per thread of the horizontal pass of Blur
+  int cellsRows = 32;     // minimum rows per thread of Cells
+  int convolveRows = 16;  // minimum rows per thread of Convolve
+  int glowRows = 16;      // minimum rows per thread of DistanceGlow
+};
+
+// Profile of this machine, loaded on first use from TuningProfilePath().
+// Missing or invalid entries keep their default.
+const TuningProfile& Tuning();
+
+// Replaces the profile of the running program. Not thread-safe: kernels
+// must not be running.
+void SetTuning(const TuningProfile& profile);
+
+// $KTG_PROFILE if set, ~/.ktg-profile otherwise.
+std::string TuningProfilePath();
+
+// Text file, one "name value" line per setting.
+// Loading returns false if the file can't be read.
+bool LoadTuningProfile(TuningProfile& profile, const char* path);
+bool SaveTuningProfile(const TuningProfile& profile, const char* path);
+
+// Benchmarks the variants of each kernel on this machine, and returns the
+// fastest ones. Timings are written to 'log', if not null.
+// The current profile is left unchanged.
+TuningProfile AutoTune(FILE* log);
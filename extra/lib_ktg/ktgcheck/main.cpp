@@ -0,0 +1,1265 @@
+/**
+ * @file main.cpp
+ * @brief Differential check of the ktg operators against their reference
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+// Usage: ktgcheck [-n iterations] [-s seed] [operator...]
+// Runs each ktg operator and its frozen reference (see reference.h) on the
+// same random inputs, and reports the first differing pixel.
+// Exits with 1 if any operator diverges.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "../ktg/blockcompress.h"
+#include "../ktg/ktg.h"
+#include "reference.h"
+
+using namespace std;
+
+namespace
+{
+// Random inputs. Each draw is logged, so a mismatch can be reproduced by
+// hand from its report.
+struct Fuzzer
+{
+  mt19937 rng;
+  string params;
+  bool large = false; // see Size
+
+  int Int(const char* name, int lo, int hi)
+  {
+    auto val = uniform_int_distribution<int>(lo, hi)(rng);
+    Log(name, to_string(val));
+    return val;
+  }
+
+  float Real(const char* name, float lo, float hi)
+  {
+    auto val = uniform_real_distribution<float>(lo, hi)(rng);
+    char buf[32];
+    snprintf(buf, sizeof buf, "%.9g", val);
+    Log(name, buf);
+    return val;
+  }
+
+  bool Bool(const char* name)
+  {
+    return Int(name, 0, 1);
+  }
+
+  void Log(const char* name, string val)
+  {
+    if(name)
+      params += string(params.empty() ? "" : ", ") + name + "=" + val;
+  }
+
+  // powers of 2, from 1 to 1 << maxLog2.
+  // Large cases always use 4 << maxLog2 (512 by default): this is where the
+  // work gets split into bands, tiles or threads.
+  int Size(const char* name, int maxLog2 = 7)
+  {
+    auto val = large ? 4 << maxLog2 : 1 << Int(nullptr, 0, maxLog2);
+    Log(name, to_string(val));
+    return val;
+  }
+
+  Pixel RandomPixel()
+  {
+    Pixel p;
+    p.a = rng();
+    p.r = rng() % (p.a + 1); // premultiplied
+    p.g = rng() % (p.a + 1);
+    p.b = rng() % (p.a + 1);
+    return p;
+  }
+
+  Texture RandomTexture(int xres, int yres)
+  {
+    Texture tex(xres, yres);
+
+    for(int i = 0; i < tex.NPixels; ++i)
+      tex.Data[i] = RandomPixel();
+
+    return tex;
+  }
+
+  Texture RandomTexture(const char* name)
+  {
+    const string n = name;
+    const int w = Size((n + ".w").c_str());
+    const int h = Size((n + ".h").c_str());
+    return RandomTexture(w, h);
+  }
+
+  Texture Gradient()
+  {
+    return RandomTexture(Size("grad.w"), 1);
+  }
+
+  Rect RandomRect(const Texture& tex)
+  {
+    Rect r;
+    r.x0 = Int("rect.x0", 0, tex.XRes);
+    r.y0 = Int("rect.y0", 0, tex.YRes);
+    r.x1 = Int("rect.x1", r.x0, tex.XRes);
+    r.y1 = Int("rect.y1", r.y0, tex.YRes);
+    return r;
+  }
+
+  // Optional region: nullptr half the time
+  const Rect* RandomRegion(const Texture& tex, Rect& storage)
+  {
+    if(Bool("region"))
+    {
+      storage = RandomRect(tex);
+      return &storage;
+    }
+
+    return nullptr;
+  }
+
+  void RandomMatrix(Matrix44& m, float range)
+  {
+    for(auto& row : m)
+      for(auto& v : row)
+        v = Real(nullptr, -range, range);
+  }
+};
+
+// Result of one check: empty if the optimized and reference results match
+typedef string Mismatch;
+
+// 'tolerance': allowed difference per channel
+Mismatch Compare(const Texture& got, const Texture& expected, int tolerance = 0)
+{
+  char msg[256];
+
+  if(got.XRes != expected.XRes || got.YRes != expected.YRes)
+  {
+    snprintf(msg, sizeof msg, "size %dx%d, expected %dx%d", got.XRes, got.YRes, expected.XRes, expected.YRes);
+    return msg;
+  }
+
+  for(int i = 0; i < got.NPixels; ++i)
+  {
+    auto& a = got.Data[i];
+    auto& b = expected.Data[i];
+
+    if(abs(a.r - b.r) > tolerance || abs(a.g - b.g) > tolerance || abs(a.b - b.b) > tolerance ||
+       abs(a.a - b.a) > tolerance)
+    {
+      snprintf(msg, sizeof msg, "pixel (%d, %d): got (%d, %d, %d, %d), expected (%d, %d, %d, %d)",
+               i % got.XRes, i / got.XRes, a.r, a.g, a.b, a.a, b.r, b.g, b.b, b.a);
+      return msg;
+    }
+  }
+
+  return Mismatch();
+}
+
+Mismatch Compare(const Rect& got, const Rect& expected)
+{
+  if(!memcmp(&got, &expected, sizeof got))
+    return Mismatch();
+
+  char msg[256];
+  snprintf(msg, sizeof msg, "rect (%d, %d, %d, %d), expected (%d, %d, %d, %d)", got.x0, got.y0, got.x1, got.y1,
+           expected.x0, expected.y0, expected.x1, expected.y1);
+  return msg;
+}
+
+Mismatch operator + (Mismatch a, Mismatch b)
+{
+  return a.empty() ? b : a;
+}
+
+bool Inside(const Rect& r, int x, int y)
+{
+  return x >= r.x0 && x < r.x1 && y >= r.y0 && y < r.y1;
+}
+
+// Expected result of an operation restricted to 'region': 'full', the
+// whole texture computed at once, cropped over 'dest', the destination before
+// the operation. The references have no regions.
+Texture Crop(const Texture& full, Texture dest, const Rect* region)
+{
+  for(int y = 0; y < dest.YRes; y++)
+  {
+    for(int x = 0; x < dest.XRes; x++)
+    {
+      if(!region || Inside(*region, x, y))
+        dest.Data[y * dest.XRes + x] = full.Data[y * dest.XRes + x];
+    }
+  }
+
+  return dest;
+}
+
+// 'changed' must hold every pixel of 'got' which differs from 'before'
+Mismatch CheckChanged(const Texture& got, const Texture& before, const Rect& changed)
+{
+  for(int y = 0; y < got.YRes; y++)
+  {
+    for(int x = 0; x < got.XRes; x++)
+    {
+      if(Inside(changed, x, y) || !memcmp(&got.Data[y * got.XRes + x], &before.Data[y * got.XRes + x], sizeof(Pixel)))
+        continue;
+
+      char msg[256];
+      snprintf(msg, sizeof msg, "pixel (%d, %d) changed outside of rect (%d, %d, %d, %d)", x, y, changed.x0,
+               changed.y0, changed.x1, changed.y1);
+      return msg;
+    }
+  }
+
+  return Mismatch();
+}
+
+// 'footprint' must hold every output pixel depending on the input pixels in
+// 'r': 'apply' is run on 'in', then on 'in' with new pixels in 'r'.
+Mismatch CheckFootprint(Fuzzer& f, const Texture& in, const Rect& r, const Rect& footprint,
+                        function<void(Texture* dest, const Texture& in)> apply)
+{
+  auto modified = in;
+
+  for(int y = r.y0; y < r.y1; y++)
+    for(int x = r.x0; x < r.x1; x++)
+      modified.Data[y * in.XRes + x] = f.RandomPixel();
+
+  Texture a(in.XRes, in.YRes), b(in.XRes, in.YRes);
+  apply(&a, in);
+  apply(&b, modified);
+
+  auto const msg = CheckChanged(b, a, footprint);
+  return msg.empty() ? msg : "footprint of (" + to_string(r.x0) + ", " + to_string(r.y0) + ", " + to_string(r.x1) +
+         ", " + to_string(r.y1) + "): " + msg;
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Generators                                                         ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+Mismatch CheckNoise(Fuzzer& f)
+{
+  const auto grad = f.Gradient();
+  const int w = f.Size("w");
+  const int h = f.Size("h");
+  const int freqX = f.Size("freqX", 4);
+  const int freqY = f.Size("freqY", 4);
+  const int oct = f.Int("oct", 1, 6);
+  const float fadeoff = f.Real("fadeoff", 0.1f, 0.95f);
+  const int seed = f.Int("seed", 0, 1000);
+  const auto mode = NoiseMode(f.Int("mode", 0, 7));
+
+  Texture got(w, h), expected(w, h);
+
+  if(f.Bool("compiled"))
+    Noise(&got, CompiledGradient(grad), freqX, freqY, oct, fadeoff, seed, mode);
+  else
+    Noise(&got, grad, freqX, freqY, oct, fadeoff, seed, mode);
+
+  Reference::Noise(&expected, grad, freqX, freqY, oct, fadeoff, seed, mode);
+
+  return Compare(got, expected);
+}
+
+Mismatch CheckGlowRect(Fuzzer& f)
+{
+  const auto grad = f.Gradient();
+  const auto bg = f.RandomTexture("bg");
+  const float orgx = f.Real("orgx", 0, 1);
+  const float orgy = f.Real("orgy", 0, 1);
+  const float ux = f.Real("ux", -0.5f, 0.5f);
+  const float uy = f.Real("uy", -0.5f, 0.5f);
+  const float vx = f.Real("vx", -0.5f, 0.5f);
+  const float vy = f.Real("vy", -0.5f, 0.5f);
+  const float rectu = f.Real("rectu", 0, 1);
+  const float rectv = f.Real("rectv", 0, 1);
+  const bool inPlace = f.Bool("inPlace");
+
+  Texture got(bg.XRes, bg.YRes), expected(bg.XRes, bg.YRes);
+  Rect changed;
+
+  if(inPlace)
+    got = bg;
+
+  auto& gotBg = inPlace ? got : bg;
+
+  if(f.Bool("compiled"))
+    GlowRect(&got, gotBg, CompiledGradient(grad), orgx, orgy, ux, uy, vx, vy, rectu, rectv, &changed);
+  else
+    GlowRect(&got, gotBg, grad, orgx, orgy, ux, uy, vx, vy, rectu, rectv, &changed);
+
+  Reference::GlowRect(&expected, bg, grad, orgx, orgy, ux, uy, vx, vy, rectu, rectv);
+
+  return Compare(got, expected) + CheckChanged(got, bg, changed);
+}
+
+Mismatch CheckCells(Fuzzer& f)
+{
+  const auto grad = f.Gradient();
+  const int w = f.Size("w");
+  const int h = f.Size("h");
+  const auto mode = CellMode(f.Int("mode", 0, 1));
+  const float amp = f.Real("amp", 0, 1);
+
+  vector<CellCenter> centers(f.Int("centers", 2, 40));
+
+  // centers on a coarse grid: many ties in distance to a row
+  const bool snap = f.Bool("snap");
+
+  for(auto& c : centers)
+  {
+    c.x = f.Real(nullptr, 0, 1);
+    c.y = f.Real(nullptr, 0, 1);
+    c.color = f.RandomPixel();
+
+    if(snap)
+    {
+      c.x = floor(c.x * 8) / 8;
+      c.y = floor(c.y * 8) / 8;
+    }
+  }
+
+  Texture got(w, h), expected(w, h);
+
+  if(f.Bool("compiled"))
+    Cells(&got, CompiledGradient(grad), centers.data(), int(centers.size()), amp, mode);
+  else
+    Cells(&got, grad, centers.data(), int(centers.size()), amp, mode);
+
+  Reference::Cells(&expected, grad, centers.data(), int(centers.size()), amp, mode);
+
+  return Compare(got, expected);
+}
+
+// Voronoi has no frozen reference: it is the cells of the PoissonDisk
+// points (checked below), with random gray levels
+Mismatch CheckVoronoi(Fuzzer& f)
+{
+  const int w = f.Size("w");
+  const int h = f.Size("h");
+  const float intensity = f.Real("intensity", 0, 1);
+  const int maxCount = f.Int("maxCount", 1, 100);
+  const float minDist = f.Real("minDist", 0, 0.5f);
+  const int seed = f.Int("seed", 0, 1000);
+
+  Texture got(w, h), expected(w, h);
+  Voronoi(&got, intensity, maxCount, minDist, seed);
+
+  vector<CellCenter> centers(maxCount);
+  const int count = PoissonDisk(centers.data(), maxCount, minDist, 123 + seed);
+
+  // same generator as Voronoi
+  uint32_t state = ((456 + seed) * 2654435761u) | 1;
+  const uint32_t maxIntens = max(1, int(intensity * 256));
+
+  for(int i = 0; i < count; i++)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    const uint16_t intens = state % maxIntens;
+    auto& color = centers[i].color;
+    color.r = color.g = color.b = (intens << 8) | intens;
+    color.a = 65535;
+  }
+
+  Texture grad(2, 1);
+  grad.Data[0] = Pixel { 65535, 65535, 65535, 65535 };
+  grad.Data[1] = Pixel { 0, 0, 0, 0 };
+
+  Reference::Cells(&expected, grad, centers.data(), count, 0.0f, CellInner);
+
+  return Compare(got, expected);
+}
+
+// PoissonDisk has no frozen reference either: its points must lie in the
+// unit square, only depend on the seed, and be at least 'minDist' apart on
+// the torus - or further, when 'maxCount' asks for fewer points: picking a
+// subset of a denser set would leave holes.
+Mismatch CheckPoissonDisk(Fuzzer& f)
+{
+  const int maxCount = f.Int("maxCount", 0, 200);
+  const float minDist = f.Real("minDist", 0, 0.5f);
+  const int seed = f.Int("seed", 0, 1000);
+
+  vector<CellCenter> points(maxCount + 1), again(maxCount + 1);
+  const int count = PoissonDisk(points.data(), maxCount, minDist, seed);
+
+  char msg[256];
+
+  if(count > maxCount || (maxCount > 0 && count == 0))
+  {
+    snprintf(msg, sizeof msg, "%d points, for at most %d", count, maxCount);
+    return msg;
+  }
+
+  // a set this sparse still fills the domain
+  const float spacing = max(minDist, min(0.5f, sqrt(0.82f / max(maxCount, 1))));
+
+  if(maxCount >= 20 && spacing == sqrt(0.82f / maxCount) && count < maxCount * 3 / 4)
+  {
+    snprintf(msg, sizeof msg, "%d points, for %d", count, maxCount);
+    return msg;
+  }
+
+  if(PoissonDisk(again.data(), maxCount, minDist, seed) != count ||
+     !equal(points.begin(), points.begin() + count, again.begin(), [] (const CellCenter& a, const CellCenter& b)
+            {
+              return a.x == b.x && a.y == b.y;
+            }))
+    return "another run gave other points";
+
+  auto wrapped = [] (float d)
+                 {
+                   d = fabs(d);
+                   return min(d, 1 - d);
+                 };
+
+  for(int i = 0; i < count; ++i)
+  {
+    auto const& p = points[i];
+
+    if(p.x < 0 || p.x >= 1 || p.y < 0 || p.y >= 1)
+    {
+      snprintf(msg, sizeof msg, "point %d: (%.9g, %.9g) outside of the unit square", i, p.x, p.y);
+      return msg;
+    }
+
+    for(int j = 0; j < i; ++j)
+    {
+      auto const dist = hypot(wrapped(p.x - points[j].x), wrapped(p.y - points[j].y));
+
+      // the rounding of the wrapped coordinates
+      if(dist < spacing * 0.9999f)
+      {
+        snprintf(msg, sizeof msg, "points %d and %d: %.9g apart, expected at least %.9g", j, i, dist, spacing);
+        return msg;
+      }
+    }
+  }
+
+  return Mismatch();
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Combiners                                                          ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+Mismatch CheckTernary(Fuzzer& f)
+{
+  const int w = f.Size("w");
+  const int h = f.Size("h");
+  const auto in1 = f.RandomTexture(w, h);
+  const auto in2 = f.RandomTexture(w, h);
+  const auto in3 = f.RandomTexture(w, h);
+  const auto op = TernaryOp(f.Int("op", 0, 1));
+
+  Texture got(w, h), expected(w, h);
+  Ternary(&got, in1, in2, in3, op);
+  Reference::Ternary(&expected, in1, in2, in3, op);
+
+  return Compare(got, expected);
+}
+
+Mismatch CheckPaste(Fuzzer& f)
+{
+  const auto bg = f.RandomTexture("bg");
+  const auto in = f.RandomTexture("in");
+  const float orgx = f.Real("orgx", -0.5f, 1);
+  const float orgy = f.Real("orgy", -0.5f, 1);
+  const float ux = f.Real("ux", -1, 1);
+  const float uy = f.Real("uy", -1, 1);
+  const float vx = f.Real("vx", -1, 1);
+  const float vy = f.Real("vy", -1, 1);
+  const auto op = CombineOp(f.Int("op", 0, CombineLighten));
+  const int mode = f.Int("mode", 0, 7);
+  const bool inPlace = f.Bool("inPlace");
+
+  Texture got(bg.XRes, bg.YRes), expected(bg.XRes, bg.YRes);
+  Rect changed;
+
+  if(inPlace)
+    got = bg;
+
+  Paste(&got, inPlace ? got : bg, in, orgx, orgy, ux, uy, vx, vy, op, mode, &changed);
+  Reference::Paste(&expected, bg, in, orgx, orgy, ux, uy, vx, vy, op, mode);
+
+  return Compare(got, expected) + CheckChanged(got, bg, changed);
+}
+
+Mismatch CheckBump(Fuzzer& f)
+{
+  const int w = f.Size("w");
+  const int h = f.Size("h");
+  const auto surface = f.RandomTexture(w, h);
+  const auto normals = f.RandomTexture(w, h);
+  const auto specular = f.Gradient();
+  const auto falloff = f.Gradient();
+  const bool useSpecular = f.Bool("specular");
+  const bool useFalloff = f.Bool("falloff");
+  const float px = f.Real("px", -1, 1);
+  const float py = f.Real("py", -1, 1);
+  const float pz = f.Real("pz", -1, 1);
+  const float dx = f.Real("dx", -1, 1);
+  const float dy = f.Real("dy", -1, 1);
+  const float dz = f.Real("dz", -1, 1);
+  const auto ambient = f.RandomPixel();
+  const auto diffuse = f.RandomPixel();
+  const bool directional = f.Bool("directional");
+
+  Rect storage;
+  auto region = f.RandomRegion(surface, storage);
+
+  // regions leave the rest of the destination untouched
+  auto got = f.RandomTexture(w, h);
+  auto before = got;
+  Texture full(w, h);
+
+  auto spec = useSpecular ? &specular : nullptr;
+  auto fall = useFalloff ? &falloff : nullptr;
+
+  if(f.Bool("compiled"))
+  {
+    const CompiledGradient compiledSpecular(specular);
+    const CompiledGradient compiledFalloff(falloff);
+    Bump(&got, surface, normals, spec ? &compiledSpecular : nullptr, fall ? &compiledFalloff : nullptr, px, py, pz,
+         dx, dy, dz, ambient, diffuse, directional, region);
+  }
+  else
+  {
+    Bump(&got, surface, normals, spec, fall, px, py, pz, dx, dy, dz, ambient, diffuse, directional, region);
+  }
+
+  Reference::Bump(&full, surface, normals, spec, fall, px, py, pz, dx, dy, dz, ambient, diffuse, directional);
+
+  return Compare(got, Crop(full, before, region));
+}
+
+Mismatch CheckLinearCombine(Fuzzer& f)
+{
+  const int w = f.Size("w");
+  const int h = f.Size("h");
+  const auto color = f.RandomPixel();
+  const float constWeight = f.Real("constWeight", -2, 2);
+
+  vector<Texture> textures(f.Int("inputs", 0, 4));
+  vector<LinearInput> inputs(textures.size());
+
+  for(size_t i = 0; i < textures.size(); ++i)
+  {
+    textures[i] = f.RandomTexture("input");
+    inputs[i].Tex = &textures[i];
+    inputs[i].Weight = f.Real("weight", -2, 2);
+    inputs[i].UShift = f.Real("ushift", -1, 1);
+    inputs[i].VShift = f.Real("vshift", -1, 1);
+    inputs[i].FilterMode = f.Int("filter", 0, 7);
+  }
+
+  Texture got(w, h), expected(w, h);
+  LinearCombine(&got, color, constWeight, inputs.data(), int(inputs.size()));
+  Reference::LinearCombine(&expected, color, constWeight, inputs.data(), int(inputs.size()));
+
+  return Compare(got, expected);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Filters                                                            ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+Mismatch CheckColorMatrixTransform(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  Matrix44 matrix;
+  f.RandomMatrix(matrix, 2);
+  const bool clampPremult = f.Bool("clampPremult");
+
+  Texture got(in.XRes, in.YRes), expected(in.XRes, in.YRes);
+  ColorMatrixTransform(&got, in, matrix, clampPremult);
+  Reference::ColorMatrixTransform(&expected, in, matrix, clampPremult);
+
+  return Compare(got, expected);
+}
+
+Mismatch CheckCoordMatrixTransform(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  Matrix44 matrix;
+  f.RandomMatrix(matrix, 2);
+  const int mode = f.Int("mode", 0, 7);
+
+  Texture got(f.Size("w"), f.Size("h"));
+  Texture expected(got.XRes, got.YRes);
+  CoordMatrixTransform(&got, in, matrix, mode);
+  Reference::CoordMatrixTransform(&expected, in, matrix, mode);
+
+  return Compare(got, expected);
+}
+
+Mismatch CheckRotozoom(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const float angle = f.Real("angle", -1, 1);
+  const float zoom = f.Real("zoom", 0.1f, 4);
+  const int mode = f.Int("mode", 0, 7);
+
+  Texture got(in.XRes, in.YRes), expected(in.XRes, in.YRes);
+  Rotozoom(&got, in, angle, zoom, mode);
+  Reference::Rotozoom(&expected, in, angle, zoom, mode);
+
+  return Compare(got, expected);
+}
+
+Mismatch CheckColorRemap(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const auto mapR = f.Gradient();
+  const auto mapG = f.Gradient();
+  const auto mapB = f.Gradient();
+
+  Rect storage;
+  auto region = f.RandomRegion(in, storage);
+
+  auto got = f.RandomTexture(in.XRes, in.YRes);
+  auto before = got;
+  Texture full(in.XRes, in.YRes);
+
+  if(f.Bool("compiled"))
+    ColorRemap(&got, in, CompiledGradient(mapR), CompiledGradient(mapG), CompiledGradient(mapB), region);
+  else
+    ColorRemap(&got, in, mapR, mapG, mapB, region);
+
+  Reference::ColorRemap(&full, in, mapR, mapG, mapB);
+
+  return Compare(got, Crop(full, before, region));
+}
+
+Mismatch CheckCoordRemap(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const auto remap = f.RandomTexture("remap");
+  const float strengthU = f.Real("strengthU", -1, 1);
+  const float strengthV = f.Real("strengthV", -1, 1);
+  const int mode = f.Int("mode", 0, 7);
+
+  Texture got(remap.XRes, remap.YRes), expected(remap.XRes, remap.YRes);
+  CoordRemap(&got, in, remap, strengthU, strengthV, mode);
+  Reference::CoordRemap(&expected, in, remap, strengthU, strengthV, mode);
+
+  return Compare(got, expected);
+}
+
+Mismatch CheckDerive(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const auto op = DeriveOp(f.Int("op", 0, DeriveNormals));
+  const float strength = f.Real("strength", -30, 30);
+
+  Rect storage;
+  auto region = f.RandomRegion(in, storage);
+
+  auto got = f.RandomTexture(in.XRes, in.YRes);
+  auto before = got;
+  Derive(&got, in, op, strength, region);
+
+  Texture full(in.XRes, in.YRes);
+  Reference::Derive(&full, in, op, strength);
+
+  return Compare(got, Crop(full, before, region));
+}
+
+Mismatch CheckBlur(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const float sizex = f.Real("sizex", 0, 1);
+  const float sizey = f.Real("sizey", 0, 1);
+  const int order = f.Int("order", 0, 4);
+  const int wrapMode = f.Int("wrapMode", 0, 3);
+  const bool inPlace = f.Bool("inPlace");
+
+  Rect storage;
+  auto region = f.RandomRegion(in, storage);
+
+  auto got = inPlace ? in : f.RandomTexture(in.XRes, in.YRes);
+  auto before = got;
+  Blur(&got, inPlace ? got : in, sizex, sizey, order, wrapMode, region);
+
+  Texture full(in.XRes, in.YRes);
+  Reference::Blur(&full, in, sizex, sizey, order, wrapMode);
+  auto expected = Crop(full, before, region);
+
+  auto blur = [&] (Texture* dest, const Texture& src)
+              {
+                Reference::Blur(dest, src, sizex, sizey, order, wrapMode);
+              };
+
+  auto r = f.RandomRect(in);
+  auto footprint = BlurFootprint(in, r, sizex, sizey, order, wrapMode);
+
+  return Compare(got, expected) + CheckFootprint(f, in, r, footprint, blur);
+}
+
+// Convolve has no frozen reference: it is checked against its definition
+void DirectConvolve(Texture* dest, const Texture& in, const vector<float>& kernel, int kw, int kh, int wrapMode)
+{
+  auto coord = [] (int x, int size, bool clampMode)
+               {
+                 return clampMode ? min(max(x, 0), size - 1) : x & (size - 1);
+               };
+
+  auto channel = [] (double v)
+                 {
+                   return uint16_t(min(max(v, 0.0), 65535.0) + 0.5);
+                 };
+
+  for(int y = 0; y < dest->YRes; y++)
+  {
+    for(int x = 0; x < dest->XRes; x++)
+    {
+      double s[4] {};
+
+      for(int j = 0; j < kh; j++)
+      {
+        for(int i = 0; i < kw; i++)
+        {
+          auto const sx = coord(x + i - kw / 2, in.XRes, wrapMode & ClampU);
+          auto const sy = coord(y + j - kh / 2, in.YRes, wrapMode & ClampV);
+          auto const& p = in.Data[sy * in.XRes + sx];
+          auto const w = kernel[j * kw + i];
+          s[0] += w * p.r;
+          s[1] += w * p.g;
+          s[2] += w * p.b;
+          s[3] += w * p.a;
+        }
+      }
+
+      auto& out = dest->Data[y * dest->XRes + x];
+      out.r = channel(s[0]);
+      out.g = channel(s[1]);
+      out.b = channel(s[2]);
+      out.a = channel(s[3]);
+    }
+  }
+}
+
+Mismatch CheckConvolve(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const int wrapMode = f.Int("wrapMode", 0, 3);
+  const bool inPlace = f.Bool("inPlace");
+
+  // separable, small (direct) or large (FFT)
+  const int kind = f.Int("kind", 0, 2);
+  const int kw = kind == 2 ? f.Int("kw", 9, 24) : f.Int("kw", 1, 8);
+  const int kh = kind == 2 ? f.Int("kh", 9, 24) : f.Int("kh", 1, 8);
+
+  vector<float> kernel(kw * kh);
+  vector<float> row(kw), column(kh);
+
+  for(auto& w : row)
+    w = f.Real(nullptr, -1, 1);
+
+  for(auto& w : column)
+    w = f.Real(nullptr, -1, 1);
+
+  for(int j = 0; j < kh; j++)
+    for(int i = 0; i < kw; i++)
+      kernel[j * kw + i] = kind == 0 ? column[j] * row[i] : f.Real(nullptr, -1, 1);
+
+  // normalized kernels keep most of the results in range
+  if(f.Bool("normalize"))
+  {
+    float sum = 0;
+
+    for(auto w : kernel)
+      sum += fabs(w);
+
+    for(auto& w : kernel)
+      w /= sum;
+  }
+
+  Rect storage;
+  auto region = f.RandomRegion(in, storage);
+
+  auto got = inPlace ? in : f.RandomTexture(in.XRes, in.YRes);
+  auto before = got;
+  Convolve(&got, inPlace ? got : in, kernel.data(), kw, kh, wrapMode, region);
+
+  Texture full(in.XRes, in.YRes);
+  DirectConvolve(&full, in, kernel, kw, kh, wrapMode);
+  auto expected = Crop(full, before, region);
+
+  // paths round differently (hence the tolerance), but a region must give
+  // exactly the pixels of the whole texture
+  Texture whole(in.XRes, in.YRes);
+  Convolve(&whole, in, kernel.data(), kw, kh, wrapMode);
+
+  auto convolve = [&] (Texture* dest, const Texture& src)
+                  {
+                    DirectConvolve(dest, src, kernel, kw, kh, wrapMode);
+                  };
+
+  auto r = f.RandomRect(in);
+  auto footprint = ConvolveFootprint(in, r, kw, kh, wrapMode);
+
+  return Compare(got, expected, 1) + Compare(got, Crop(whole, before, region)) +
+         CheckFootprint(f, in, r, footprint, convolve);
+}
+
+// Morphology has no frozen reference either: checked against its definition.
+// The max (or min) over a rectangle is the max over its columns of the max
+// over its rows.
+Texture DirectMorph(const Texture& in, int rx, int ry, bool dilate, int wrapMode)
+{
+  auto coord = [] (int x, int size, bool clampMode)
+               {
+                 return clampMode ? min(max(x, 0), size - 1) : x & (size - 1);
+               };
+
+  auto combine = [dilate] (Pixel& r, const Pixel& p)
+                 {
+                   r.r = dilate ? max(r.r, p.r) : min(r.r, p.r);
+                   r.g = dilate ? max(r.g, p.g) : min(r.g, p.g);
+                   r.b = dilate ? max(r.b, p.b) : min(r.b, p.b);
+                   r.a = dilate ? max(r.a, p.a) : min(r.a, p.a);
+                 };
+
+  Texture rows(in.XRes, in.YRes), out(in.XRes, in.YRes);
+
+  for(int y = 0; y < in.YRes; y++)
+  {
+    for(int x = 0; x < in.XRes; x++)
+    {
+      auto r = in.Data[y * in.XRes + x];
+
+      for(int i = -rx; i <= rx; i++)
+        combine(r, in.Data[y * in.XRes + coord(x + i, in.XRes, wrapMode & ClampU)]);
+
+      rows.Data[y * in.XRes + x] = r;
+    }
+  }
+
+  for(int y = 0; y < in.YRes; y++)
+  {
+    for(int x = 0; x < in.XRes; x++)
+    {
+      auto r = rows.Data[y * in.XRes + x];
+
+      for(int j = -ry; j <= ry; j++)
+        combine(r, rows.Data[coord(y + j, in.YRes, wrapMode & ClampV) * in.XRes + x]);
+
+      out.Data[y * in.XRes + x] = r;
+    }
+  }
+
+  return out;
+}
+
+Mismatch CheckMorphology(Fuzzer& f)
+{
+  const auto in = f.RandomTexture("in");
+  const float sizex = f.Real("sizex", 0, 0.3f);
+  const float sizey = f.Real("sizey", 0, 0.3f);
+  const auto op = MorphOp(f.Int("op", 0, MorphClose));
+  const int wrapMode = f.Int("wrapMode", 0, 3);
+  const bool inPlace = f.Bool("inPlace");
+
+  Rect storage;
+  auto region = f.RandomRegion(in, storage);
+
+  auto got = inPlace ? in : f.RandomTexture(in.XRes, in.YRes);
+  auto before = got;
+  Morphology(&got, inPlace ? got : in, sizex, sizey, op, wrapMode, region);
+
+  // same radius as Morphology
+  const int rx = sizex * in.XRes / 2;
+  const int ry = sizey * in.YRes / 2;
+
+  auto morph = [&] (Texture* dest, const Texture& src)
+               {
+                 *dest = DirectMorph(src, rx, ry, op == MorphDilate || op == MorphClose, wrapMode);
+
+                 if(op == MorphOpen || op == MorphClose)
+                   *dest = DirectMorph(*dest, rx, ry, op == MorphOpen, wrapMode);
+               };
+
+  Texture full;
+  morph(&full, in);
+  auto expected = Crop(full, before, region);
+
+  auto footprintRect = f.RandomRect(in);
+  auto footprint = MorphologyFootprint(in, footprintRect, sizex, sizey, op, wrapMode);
+
+  return Compare(got, expected) + CheckFootprint(f, in, footprintRect, footprint, morph);
+}
+
+// The distance transform is checked against the nearest inside pixel,
+// found by brute force
+Mismatch CheckDistanceGlow(Fuzzer& f)
+{
+  const int w = f.Size("w", 5);
+  const int h = f.Size("h", 5);
+  const auto bg = f.RandomTexture(w, h);
+  const auto grad = f.Gradient();
+  const int channel = f.Int("channel", 0, 3);
+  const float threshold = f.Real("threshold", 0, 1);
+  const float radius = f.Real("radius", 0, 1);
+  const int wrapMode = f.Int("wrapMode", 0, 3);
+
+  // sparse shapes, so that the distances aren't all tiny
+  auto shape = f.RandomTexture(w, h);
+  const int density = f.Int("density", 0, 64);
+
+  for(int i = 0; i < shape.NPixels; ++i)
+  {
+    if(f.Int(nullptr, 0, 63) >= density)
+      shape.Data[i].r = shape.Data[i].g = shape.Data[i].b = shape.Data[i].a = 0;
+  }
+
+  Texture got(w, h);
+  DistanceGlow(&got, bg, shape, grad, channel, threshold, radius, wrapMode);
+
+  vector<float> dist2(shape.NPixels);
+  DistanceTransform(dist2.data(), shape, channel, threshold, wrapMode);
+
+  const int level = min(max(int(threshold * 65535.0f + 0.5f), 0), 65535);
+
+  auto delta = [] (int a, int b, int size, bool clampMode)
+               {
+                 const int d = abs(a - b);
+                 return clampMode ? d : min(d, size - d);
+               };
+
+  vector<float> expectedDist2(shape.NPixels, 1e20f);
+
+  for(int y = 0; y < h; y++)
+  {
+    for(int x = 0; x < w; x++)
+    {
+      for(int j = 0; j < h; j++)
+      {
+        for(int i = 0; i < w; i++)
+        {
+          auto const& p = shape.Data[j * w + i];
+          const int val = channel == 0 ? p.r : channel == 1 ? p.g : channel == 2 ? p.b : p.a;
+
+          if(val < level)
+            continue;
+
+          const int dx = delta(x, i, w, wrapMode & ClampU);
+          const int dy = delta(y, j, h, wrapMode & ClampV);
+          expectedDist2[y * w + x] = min(expectedDist2[y * w + x], float(dx * dx + dy * dy));
+        }
+      }
+    }
+  }
+
+  auto expected = bg;
+
+  for(int i = 0; radius > 0 && i < expected.NPixels; ++i)
+  {
+    auto const t = sqrt(double(expectedDist2[i])) * (1.0 / (double(radius) * w));
+
+    if(t < 1)
+    {
+      Pixel col;
+      Reference::SampleGradient(grad, col, int((1 << 24) * t));
+      Reference::CompositeROver(expected.Data[i], col);
+    }
+  }
+
+  for(int i = 0; i < shape.NPixels; ++i)
+  {
+    if(dist2[i] != expectedDist2[i])
+    {
+      char msg[256];
+      snprintf(msg, sizeof msg, "distance2 (%d, %d): got %g, expected %g", i % w, i / w, dist2[i], expectedDist2[i]);
+      return msg;
+    }
+  }
+
+  return Compare(got, expected);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Block compression                                                  ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+// Palettes and indices of encoded blocks, as GPUs decode them
+void DecodeBC1(const uint8_t* src, float palette[4][3], uint32_t& indices)
+{
+  const int c[2] = { src[0] | src[1] << 8, src[2] | src[3] << 8 };
+
+  for(int k = 0; k < 2; ++k)
+  {
+    const int r = c[k] >> 11, g = (c[k] >> 5) & 63, b = c[k] & 31;
+    palette[k][0] = (r << 3) | (r >> 2);
+    palette[k][1] = (g << 2) | (g >> 4);
+    palette[k][2] = (b << 3) | (b >> 2);
+  }
+
+  for(int i = 0; i < 3; ++i)
+  {
+    if(c[0] > c[1])
+    {
+      palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+      palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+    }
+    else
+    {
+      palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+      palette[3][i] = 0;
+    }
+  }
+
+  indices = src[4] | src[5] << 8 | src[6] << 16 | uint32_t(src[7]) << 24;
+}
+
+void DecodeBC4(const uint8_t* src, float palette[8], uint64_t& indices)
+{
+  const int a0 = src[0], a1 = src[1];
+  palette[0] = a0;
+  palette[1] = a1;
+
+  if(a0 > a1)
+  {
+    for(int i = 2; i < 8; ++i)
+      palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7.0f;
+  }
+  else
+  {
+    for(int i = 2; i < 6; ++i)
+      palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5.0f;
+
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+
+  indices = 0;
+
+  for(int i = 0; i < 6; ++i)
+    indices |= uint64_t(src[2 + i]) << (8 * i);
+}
+
+// Encoders aren't exact: each pixel must get the nearest color of its block's
+// palette, and solid blocks must be within the rounding of the endpoints.
+Mismatch CheckBlockCompression(Fuzzer& f)
+{
+  auto tex = f.RandomTexture("tex");
+  const auto format = BlockFormat(f.Int("format", 0, BlockBC5));
+  const bool solid = f.Bool("solid");
+
+  if(solid)
+  {
+    for(int i = 1; i < tex.NPixels; ++i)
+      tex.Data[i] = tex.Data[0];
+  }
+
+  const int blocksX = (tex.XRes + 3) / 4;
+  const int blocksY = (tex.YRes + 3) / 4;
+  const int bytes = BlockBytes(format);
+  vector<uint8_t> data(blocksX * blocksY * bytes);
+
+  for(int by = 0; by < blocksY; ++by)
+    EncodeBlockRow(&data[by * blocksX * bytes], tex, by, format);
+
+  // channel encoded by each half of a block, -1 for BC1 colors
+  const int parts[4][2] = { { -1, -1 }, { 3, -1 }, { 0, -1 }, { 0, 1 } };
+  const int numParts = bytes / 8;
+  char msg[256];
+
+  for(int block = 0; block < blocksX * blocksY; ++block)
+  {
+    for(int part = 0; part < numParts; ++part)
+    {
+      const auto src = &data[block * bytes + part * 8];
+      const int channel = parts[format][part];
+
+      float colors[4][3], values[8];
+      uint32_t colorIndices = 0;
+      uint64_t valueIndices = 0;
+
+      if(channel < 0)
+      {
+        DecodeBC1(src, colors, colorIndices);
+
+        // the 3 colors mode turns index 3 into black
+        const int c0 = src[0] | src[1] << 8;
+        const int c1 = src[2] | src[3] << 8;
+
+        if(c0 == c1 ? colorIndices != 0 : c0 < c1)
+        {
+          snprintf(msg, sizeof msg, "block %d: 3 colors mode", block);
+          return msg;
+        }
+      }
+      else
+        DecodeBC4(src, values, valueIndices);
+
+      for(int i = 0; i < 16; ++i)
+      {
+        const int x = (block % blocksX) * 4 + i % 4;
+        const int y = (block / blocksX) * 4 + i / 4;
+
+        if(x >= tex.XRes || y >= tex.YRes)
+          continue;
+
+        const auto pel = &tex.Data[y * tex.XRes + x].r;
+        const int numColors = channel < 0 ? 4 : 8;
+        const int index = channel < 0 ? (colorIndices >> (2 * i)) & 3 : (valueIndices >> (3 * i)) & 7;
+
+        auto error = [&] (int k, int c)
+                     {
+                       auto const v = pel[channel < 0 ? c : channel] * (255.0f / 65535.0f);
+                       return channel < 0 ? fabs(v - colors[k][c]) : fabs(v - values[k]);
+                     };
+
+        auto distance = [&] (int k)
+                        {
+                          float d = 0;
+
+                          for(int c = 0; c < (channel < 0 ? 3 : 1); ++c)
+                            d += error(k, c) * error(k, c);
+
+                          return d;
+                        };
+
+        for(int k = 0; k < numColors; ++k)
+        {
+          if(distance(k) < distance(index) - 1e-3f)
+          {
+            snprintf(msg, sizeof msg, "block %d, pixel %d, channel %d: index %d, %d is nearer", block, i, channel,
+                     index, k);
+            return msg;
+          }
+        }
+
+        // 5, 6 and 8 bits endpoints
+        const float maxError[3] = { 4.51f, 2.51f, 4.51f };
+
+        for(int c = 0; solid && c < (channel < 0 ? 3 : 1); ++c)
+        {
+          if(error(index, c) > (channel < 0 ? maxError[c] : 0.51f))
+          {
+            snprintf(msg, sizeof msg, "block %d, pixel %d, channel %d: error %g", block, i, channel < 0 ? c : channel,
+                     error(index, c));
+            return msg;
+          }
+        }
+      }
+    }
+  }
+
+  return Mismatch();
+}
+
+struct Check
+{
+  const char* name;
+  function<Mismatch(Fuzzer &)> func;
+};
+
+const Check Checks[] =
+{
+  { "Noise", &CheckNoise },
+  { "GlowRect", &CheckGlowRect },
+  { "Cells", &CheckCells },
+  { "Voronoi", &CheckVoronoi },
+  { "PoissonDisk", &CheckPoissonDisk },
+  { "Ternary", &CheckTernary },
+  { "Paste", &CheckPaste },
+  { "Bump", &CheckBump },
+  { "LinearCombine", &CheckLinearCombine },
+  { "ColorMatrixTransform", &CheckColorMatrixTransform },
+  { "CoordMatrixTransform", &CheckCoordMatrixTransform },
+  { "Rotozoom", &CheckRotozoom },
+  { "ColorRemap", &CheckColorRemap },
+  { "CoordRemap", &CheckCoordRemap },
+  { "Derive", &CheckDerive },
+  { "Blur", &CheckBlur },
+  { "Convolve", &CheckConvolve },
+  { "Morphology", &CheckMorphology },
+  { "DistanceGlow", &CheckDistanceGlow },
+  { "BlockCompression", &CheckBlockCompression },
+};
+}
+
+// one case out of LargeCasePeriod uses large textures
+const unsigned LargeCasePeriod = 50;
+
+int main(int argc, char** argv)
+{
+  int iterations = 200;
+  unsigned seed = 1;
+  vector<string> only;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(!strcmp(argv[i], "-n") && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "-s") && i + 1 < argc)
+      seed = strtoul(argv[++i], nullptr, 0);
+    else
+      only.push_back(argv[i]);
+  }
+
+  int failures = 0;
+
+  for(auto& check : Checks)
+  {
+    if(!only.empty() && find(only.begin(), only.end(), check.name) == only.end())
+      continue;
+
+    Mismatch mismatch;
+    Fuzzer f;
+    int i;
+
+    for(i = 0; i < iterations && mismatch.empty(); ++i)
+    {
+      // each iteration can be replayed on its own
+      f.rng.seed(seed + i);
+      f.params.clear();
+      f.large = (seed + i) % LargeCasePeriod == 0;
+      mismatch = check.func(f);
+    }
+
+    if(mismatch.empty())
+    {
+      printf("%-22s OK (%d cases)\n", check.name, iterations);
+      continue;
+    }
+
+    printf("%-22s MISMATCH at case %d (-s %u -n 1): %s\n", check.name, i - 1, seed + i - 1, mismatch.c_str());
+    printf("%-22s   %s\n", "", f.params.c_str());
+    ++failures;
+  }
+
+  return failures ? 1 : 0;
+}
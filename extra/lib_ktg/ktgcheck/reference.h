@@ -0,0 +1,71 @@
+/**
+ * @file reference.h
+ * @brief Frozen reference implementation of the ktg operators
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include "../ktg/gentexture.h"
+
+// Copies of generators.cpp, combiners.cpp and filters.cpp (and helpers.h),
+// taken before any SIMD, threaded or specialized path was added.
+// Never modify them: optimized versions must give the same pixels.
+// Only the storage of Texture (gentexture.cpp) is shared with the optimized
+// code: the pixel operations and the sampling helpers are frozen too, and
+// gradients are always sampled by SampleGradient.
+namespace Reference
+{
+///////////////////////////////////////////////////////////////////////////////
+// Pixels and sampling (Pixel and Texture methods, as free functions)
+///////////////////////////////////////////////////////////////////////////////
+void Lerp(Pixel& p, int t, Pixel x, Pixel y); // t=0..65536
+void CompositeAdd(Pixel& p, Pixel x);
+void CompositeMulC(Pixel& p, Pixel x);
+void CompositeROver(Pixel& p, Pixel x);
+void CompositeScreen(Pixel& p, Pixel x);
+
+void SampleNearest(const Texture& tex, Pixel& result, int x, int y, int wrapMode);
+void SampleBilinear(const Texture& tex, Pixel& result, int x, int y, int wrapMode);
+void SampleFiltered(const Texture& tex, Pixel& result, int x, int y, int filterMode);
+void SampleGradient(const Texture& tex, Pixel& result, int x);
+
+///////////////////////////////////////////////////////////////////////////////
+// Generators
+///////////////////////////////////////////////////////////////////////////////
+void Noise(Texture* dest, const Texture& grad, int freqX, int freqY, int oct, float fadeoff, int seed, NoiseMode mode);
+void GlowRect(Texture* dest, const Texture& bgTex, const Texture& grad, float orgx, float orgy, float ux, float uy,
+              float vx, float vy, float rectu, float rectv);
+void Cells(Texture* dest, const Texture& grad, const CellCenter* centers, int nCenters, float amp, CellMode mode);
+
+///////////////////////////////////////////////////////////////////////////////
+// Combiners
+///////////////////////////////////////////////////////////////////////////////
+void Ternary(Texture* dest, const Texture& in1Tex, const Texture& in2Tex, const Texture& in3Tex, TernaryOp op);
+void Paste(Texture* dest, const Texture& bgTex, const Texture& inTex, float orgx, float orgy, float ux, float uy,
+           float vx, float vy, CombineOp op, int mode);
+void Bump(Texture* dest, const Texture& surface, const Texture& normals, const Texture* specular,
+          const Texture* falloffMap, float px, float py, float pz, float dx, float dy, float dz, Pixel ambient,
+          Pixel diffuse, bool directional);
+void LinearCombine(Texture* dest, Pixel color, float constWeight, const LinearInput* inputs, int nInputs);
+
+///////////////////////////////////////////////////////////////////////////////
+// Filters
+///////////////////////////////////////////////////////////////////////////////
+void ColorMatrixTransform(Texture* dest, const Texture& x, Matrix44& matrix, bool clampPremult);
+void CoordMatrixTransform(Texture* dest, const Texture& in, Matrix44& matrix, int mode);
+void Rotozoom(Texture* dest, const Texture& in, float angle, float zoom, int mode);
+void ColorRemap(Texture* dest, const Texture& inTex, const Texture& mapR, const Texture& mapG, const Texture& mapB);
+void CoordRemap(Texture* dest, const Texture& in, const Texture& remapTex, float strengthU, float strengthV, int mode);
+void Derive(Texture* dest, const Texture& in, DeriveOp op, float strength);
+void Blur(Texture* dest, const Texture& inImg, float sizex, float sizey, int order, int wrapMode);
+}
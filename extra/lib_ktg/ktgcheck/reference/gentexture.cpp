@@ -0,0 +1,134 @@
+/**
+ * @file gentexture.cpp
+ * @brief Frozen copy of the pixel operations and sampling helpers of ktg/gentexture.cpp
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "../reference.h"
+#include "helpers.h"
+
+namespace Reference
+{
+/****************************************************************************/
+/***                                                                      ***/
+/***   Pixel                                                              ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+void Lerp(Pixel& p, int t, Pixel x, Pixel y)
+{
+  p.r = Lerp(t, x.r, y.r);
+  p.g = Lerp(t, x.g, y.g);
+  p.b = Lerp(t, x.b, y.b);
+  p.a = Lerp(t, x.a, y.a);
+}
+
+void CompositeAdd(Pixel& p, Pixel x)
+{
+  p.r = clamp<int>(p.r + x.r, 0, 65535);
+  p.g = clamp<int>(p.g + x.g, 0, 65535);
+  p.b = clamp<int>(p.b + x.b, 0, 65535);
+  p.a = clamp<int>(p.a + x.a, 0, 65535);
+}
+
+void CompositeMulC(Pixel& p, Pixel x)
+{
+  p.r = MulIntens(p.r, x.r);
+  p.g = MulIntens(p.g, x.g);
+  p.b = MulIntens(p.b, x.b);
+  p.a = MulIntens(p.a, x.a);
+}
+
+void CompositeROver(Pixel& p, Pixel x)
+{
+  int transIn = 65535 - x.a;
+  p.r = MulIntens(transIn, p.r) + x.r;
+  p.g = MulIntens(transIn, p.g) + x.g;
+  p.b = MulIntens(transIn, p.b) + x.b;
+  p.a = MulIntens(transIn, p.a) + x.a;
+}
+
+void CompositeScreen(Pixel& p, Pixel x)
+{
+  p.r += MulIntens(x.r, 65535 - p.r);
+  p.g += MulIntens(x.g, 65535 - p.g);
+  p.b += MulIntens(x.b, 65535 - p.b);
+  p.a += MulIntens(x.a, 65535 - p.a);
+}
+
+/****************************************************************************/
+/***                                                                      ***/
+/***   Texture sampling                                                   ***/
+/***                                                                      ***/
+/****************************************************************************/
+
+void SampleNearest(const Texture& tex, Pixel& result, int x, int y, int wrapMode)
+{
+  if(wrapMode & 1)
+    x = clamp(x, tex.MinX, 0x1000000 - tex.MinX);
+
+  if(wrapMode & 2)
+    y = clamp(y, tex.MinY, 0x1000000 - tex.MinY);
+
+  x &= 0xffffff;
+  y &= 0xffffff;
+
+  int ix = x >> (24 - tex.ShiftX);
+  int iy = y >> (24 - tex.ShiftY);
+
+  result = tex.Data[(iy << tex.ShiftX) + ix];
+}
+
+void SampleBilinear(const Texture& tex, Pixel& result, int x, int y, int wrapMode)
+{
+  if(wrapMode & 1)
+    x = clamp(x, tex.MinX, 0x1000000 - tex.MinX);
+
+  if(wrapMode & 2)
+    y = clamp(y, tex.MinY, 0x1000000 - tex.MinY);
+
+  x = (x - tex.MinX) & 0xffffff;
+  y = (y - tex.MinY) & 0xffffff;
+
+  int x0 = x >> (24 - tex.ShiftX);
+  int x1 = (x0 + 1) & (tex.XRes - 1);
+  int y0 = y >> (24 - tex.ShiftY);
+  int y1 = (y0 + 1) & (tex.YRes - 1);
+  int fx = uint32_t(x << (tex.ShiftX + 8)) >> 16;
+  int fy = uint32_t(y << (tex.ShiftY + 8)) >> 16;
+
+  Pixel t0, t1;
+  Lerp(t0, fx, tex.Data[(y0 << tex.ShiftX) + x0], tex.Data[(y0 << tex.ShiftX) + x1]);
+  Lerp(t1, fx, tex.Data[(y1 << tex.ShiftX) + x0], tex.Data[(y1 << tex.ShiftX) + x1]);
+  Lerp(result, fy, t0, t1);
+}
+
+void SampleFiltered(const Texture& tex, Pixel& result, int x, int y, int filterMode)
+{
+  if(filterMode & FilterBilinear)
+    SampleBilinear(tex, result, x, y, filterMode);
+  else
+    SampleNearest(tex, result, x, y, filterMode);
+}
+
+void SampleGradient(const Texture& tex, Pixel& result, int x)
+{
+  x = clamp(x, 0, 1 << 24);
+  x -= x >> tex.ShiftX; // x=(1<<24) -> Take rightmost pixel
+
+  int x0 = x >> (24 - tex.ShiftX);
+  int x1 = (x0 + 1) & (tex.XRes - 1);
+  int fx = uint32_t(x << (tex.ShiftX + 8)) >> 16;
+
+  Lerp(result, fx, tex.Data[x0], tex.Data[x1]);
+}
+}
@@ -0,0 +1,261 @@
+/**
+ * @file main.cpp
+ * @brief Batch renderer for serialized edit lists
+ * @author Sebastien Alaiwan
+ * @date 2026-10-19
+ */
+
+/*
+ * Copyright (C) 2016 - Sebastien Alaiwan
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+// Usage: ktgrender [-j jobs] [-o outputDir] [-f bmp|png|raw|bc1|bc3|bc4|bc5] [-16] [-d]
+//                  [-a count [-g gutter] [-v op:arg:step]...] documents...
+//        ktgrender -t
+// Each document (as written by 'architect --binary') is rendered
+// to an image file with the same base name.
+//   -f: bc1 (rgb), bc3 (rgba), bc4 (r) and bc5 (rg, for normal maps) write
+//       block compressed DDS files, ready for the GPU
+//   -16: keep 16 bits per channel (png and raw)
+//   -d: dither when reducing to 8 bits per channel
+//   -a: render 'count' variants of each document, packed into an atlas.
+//       Variant i uses seed i, and adds i * step to argument 'arg' of
+//       operation 'op' for each -v. The texture coordinates of the tiles
+//       are written to a .uv file, one "u0 v0 u1 v1" line per tile.
+//   -g: texels around each tile of an atlas (default: 2)
+//   -t: benchmark the kernel variants on this machine, and save the fastest
+//       ones to the profile loaded by ktg (see tuning.h)
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../ktg/atlas.h"
+#include "../ktg/exporter.h"
+#include "../ktg/runtime.h"
+#include "../ktg/tuning.h"
+
+using namespace std;
+
+namespace
+{
+struct Options
+{
+  string outputDir;
+  ExportFormat format = ExportBMP;
+  int flags = 0;
+  int threadsPerDocument = 1;
+
+  // atlas
+  int variants = 0;
+  int gutter = 2;
+  vector<ArgOverride> steps; // value: increment per variant
+};
+
+// indexed by ExportFormat
+const char* const FormatNames[] = { "bmp", "png", "raw", "bc1", "bc3", "bc4", "bc5" };
+const char* const Extensions[] = { ".bmp", ".png", ".raw", ".dds", ".dds", ".dds", ".dds" };
+
+string outputPath(string input, const Options& options)
+{
+  auto base = input.substr(input.find_last_of('/') + 1);
+  auto dot = base.find_last_of('.');
+
+  if(dot != string::npos)
+    base = base.substr(0, dot);
+
+  if(!options.outputDir.empty())
+    base = options.outputDir + "/" + base;
+  else if(input.find('/') != string::npos)
+    base = input.substr(0, input.find_last_of('/') + 1) + base;
+
+  return base + Extensions[options.format];
+}
+
+void bakeAtlas(const Document& doc, string input, const Options& options, Texture& atlas)
+{
+  vector<Variant> variants(options.variants);
+
+  for(int i = 0; i < options.variants; ++i)
+  {
+    variants[i].seed = i;
+
+    for(auto step : options.steps)
+    {
+      if(step.op >= int(doc.ops.size()) || step.arg >= int(doc.ops[step.op].args.size()))
+        throw runtime_error("invalid argument override");
+
+      auto& arg = doc.ops[step.op].args[step.arg];
+
+      if(arg.type != ArgReal)
+        throw runtime_error("only Real arguments can vary");
+
+      variants[i].overrides.push_back(ArgOverride { step.op, step.arg, arg.v[0] + i * step.value });
+    }
+  }
+
+  vector<AtlasTile> uvs;
+  BakeAtlas(doc, variants, options.gutter, atlas, uvs, options.threadsPerDocument);
+
+  auto path = outputPath(input, options);
+  path = path.substr(0, path.find_last_of('.')) + ".uv";
+
+  FILE* fp = fopen(path.c_str(), "w");
+
+  if(!fp)
+    throw runtime_error("can't write '" + path + "'");
+
+  for(auto& uv : uvs)
+    fprintf(fp, "%.9g %.9g %.9g %.9g\n", uv.u0, uv.v0, uv.u1, uv.v1);
+
+  if(fclose(fp) != 0)
+    throw runtime_error("can't write '" + path + "'");
+}
+
+void renderFile(string input, const Options& options)
+{
+  Document doc;
+  LoadDocumentFile(doc, input.c_str());
+
+  Texture result;
+
+  if(options.variants > 0)
+    bakeAtlas(doc, input, options, result);
+  else
+    RenderDocument(doc, result, options.threadsPerDocument);
+
+  if(!result.Data)
+    throw runtime_error("nothing to display");
+
+  auto path = outputPath(input, options);
+
+  if(!ExportTexture(result, path.c_str(), options.format, options.flags))
+    throw runtime_error("can't write '" + path + "'");
+}
+
+int autoTune()
+{
+  auto profile = AutoTune(stderr);
+  auto path = TuningProfilePath();
+
+  if(!SaveTuningProfile(profile, path.c_str()))
+  {
+    fprintf(stderr, "Fatal: can't write '%s'\n", path.c_str());
+    return 1;
+  }
+
+  fprintf(stderr, "Profile written to '%s'\n", path.c_str());
+  return 0;
+}
+}
+
+int main(int argc, char** argv)
+{
+  int jobs = thread::hardware_concurrency();
+  Options options;
+  vector<string> inputs;
+  bool usage = false;
+  bool tune = false;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    if(!strcmp(argv[i], "-j") && i + 1 < argc)
+      jobs = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "-o") && i + 1 < argc)
+      options.outputDir = argv[++i];
+    else if(!strcmp(argv[i], "-f") && i + 1 < argc)
+    {
+      auto name = string(argv[++i]);
+      auto format = find(begin(FormatNames), end(FormatNames), name);
+      usage |= format == end(FormatNames);
+      options.format = ExportFormat(format - begin(FormatNames));
+    }
+    else if(!strcmp(argv[i], "-16"))
+      options.flags |= Export16Bit;
+    else if(!strcmp(argv[i], "-d"))
+      options.flags |= ExportDither;
+    else if(!strcmp(argv[i], "-a") && i + 1 < argc)
+      options.variants = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "-g") && i + 1 < argc)
+      options.gutter = atoi(argv[++i]);
+    else if(!strcmp(argv[i], "-v") && i + 1 < argc)
+    {
+      ArgOverride step;
+      usage |= sscanf(argv[++i], "%d:%d:%f", &step.op, &step.arg, &step.value) != 3 || step.op < 0 || step.arg < 0;
+      options.steps.push_back(step);
+    }
+    else if(!strcmp(argv[i], "-t"))
+      tune = true;
+    else
+      inputs.push_back(argv[i]);
+  }
+
+  if(tune && inputs.empty() && !usage)
+    return autoTune();
+
+  if(inputs.empty() || usage)
+  {
+    fprintf(stderr, "Usage: %s [-j jobs] [-o outputDir] [-f bmp|png|raw|bc1|bc3|bc4|bc5] [-16] [-d]\n", argv[0]);
+    fprintf(stderr, "         [-a count [-g gutter] [-v op:arg:step]...] documents...\n");
+    fprintf(stderr, "       %s -t\n", argv[0]);
+    return 1;
+  }
+
+  // the threads left when there are fewer documents than jobs render
+  // independent branches of each document
+  options.threadsPerDocument = max(1, jobs / int(inputs.size()));
+  jobs = max(1, min(jobs, int(inputs.size())));
+
+  // one error message per document, empty on success
+  vector<string> errors(inputs.size());
+  atomic<size_t> next(0);
+
+  auto worker = [&] ()
+                {
+                  size_t i;
+
+                  while((i = next++) < inputs.size())
+                  {
+                    try
+                    {
+                      renderFile(inputs[i], options);
+                    }
+                    catch(exception& e)
+                    {
+                      errors[i] = e.what();
+                    }
+                  }
+                };
+
+  vector<thread> threads;
+
+  for(int i = 1; i < jobs; ++i)
+    threads.push_back(thread(worker));
+
+  worker();
+
+  for(auto& t : threads)
+    t.join();
+
+  int ret = 0;
+
+  for(size_t i = 0; i < inputs.size(); ++i)
+  {
+    if(errors[i].empty())
+      continue;
+
+    fprintf(stderr, "Fatal: %s: %s\n", inputs[i].c_str(), errors[i].c_str());
+    ret = 1;
+  }
+
+  return ret;
+}
@@ -1,9 +1,25 @@
 srcs:=\
 	$(THIS)/ktg.d\
-	$(THIS)/ktg_generators.d\
-	$(THIS)/ktg_filters.d\
+	$(THIS)/ktg/blockcompress.cpp\
 	$(THIS)/ktg/combiners.cpp\
+	$(THIS)/ktg/exporter.cpp\
 	$(THIS)/ktg/filters.cpp\
 	$(THIS)/ktg/generators.cpp\
 	$(THIS)/ktg/gentexture.cpp\
+	$(THIS)/ktg/heightmesh.cpp\
+	$(THIS)/ktg/parallel.cpp\
+	$(THIS)/ktg/tuning.cpp\
 
+runtime:=\
+	$(THIS)/ktg/atlas.cpp\
+	$(THIS)/ktg/runtime.cpp\
+
+ktgrender:=\
+	$(THIS)/ktgrender/main.cpp\
+
+ktgcheck:=\
+	$(THIS)/ktgcheck/main.cpp\
+	$(THIS)/ktgcheck/reference/combiners.cpp\
+	$(THIS)/ktgcheck/reference/filters.cpp\
+	$(THIS)/ktgcheck/reference/generators.cpp\
+	$(THIS)/ktgcheck/reference/gentexture.cpp\
@@ -18,6 +18,7 @@ srcs:=\
 	$(THIS)/ops_tilemap.d\
 	$(THIS)/parser.d\
 	$(THIS)/raii.d\
+	$(THIS)/texture_cache.d\
 	$(THIS)/value.d\
 	$(THIS)/vect.d\
 
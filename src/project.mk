@@ -8,6 +8,7 @@ DFLAGS+=$(shell pkg-config gtkd-3 --cflags)
 LDFLAGS+=$(shell pkg-config gtkdsv-3 gtkd-3 glu --static --libs)
 
 architect-gui.srcs:=\
+  $(THIS)/background.d\
   $(THIS)/cmdline.d\
   $(THIS)/glshader.d\
   $(THIS)/gtkmain.d\